@@ -13,6 +13,16 @@ namespace common
         queue,
         battle
     };
+
+	// changed fields of a player since the last save
+    enum PlayerDirtyField : uint8_t
+    {
+        DirtyNone = 0,
+        DirtyScore = 1 << 0,
+        DirtyWins = 1 << 1,
+		DirtyStatus = 1 << 2,   // not persisted
+        DirtyPersisted = DirtyScore | DirtyWins
+    };
 }
 
 namespace battle
@@ -46,4 +56,62 @@ namespace battle
     };
 }
 
+namespace schedule
+{
+	// ready tasks with a higher priority run first
+    enum TaskPriority : uint8_t
+    {
+        TaskPriorityLow = 0,
+        TaskPriorityNormal = 1,
+        TaskPriorityHigh = 2
+    };
+
+	// how the next execution time of a repeating task is computed
+    enum TaskMode : uint8_t
+    {
+        TaskModeFixedRate = 0,      // one interval after the previous due time, no drift
+        TaskModeFixedDelay = 1      // one interval after the previous callback returned
+    };
+
+	// what a fixed-rate task does when a callback overran one or more periods
+    enum CatchUpPolicy : uint8_t
+    {
+        CatchUpSkip = 0,            // skip the missed periods, stay on the original period grid
+        CatchUpBurst = 1,           // run the missed periods back to back until caught up
+        CatchUpRestart = 2          // start a new period grid when the callback returned
+    };
+}
+
+namespace timing
+{
+	// time source of ClockManager
+    enum ClockMode : uint8_t
+    {
+        ClockModeRealTime = 0,      // steady_clock / system_clock, sleeps take real time
+        ClockModeVirtual = 1        // discrete-event simulation, time jumps to the next wake-up once every participant waits
+    };
+}
+
+namespace load
+{
+	// arrival process of the load generator
+    enum ArrivalProcess : uint8_t
+    {
+        ArrivalPoisson = 0,         // single players, exponential inter-arrival times
+        ArrivalBursty = 1           // groups of players (geometric size) at exponential intervals, same mean rate
+    };
+}
+
+namespace logging
+{
+	// records below the level of LogManager are dropped by the caller
+    enum LogLevel : uint8_t
+    {
+        LogLevelDebug = 0,          // per-event lines (queues, rooms), compiled out in release
+        LogLevelInfo = 1,
+        LogLevelWarning = 2,
+        LogLevelError = 3
+    };
+}
+
 #endif // GLOBAL_DEFINE_H
\ No newline at end of file
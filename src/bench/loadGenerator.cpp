@@ -0,0 +1,209 @@
+// @file  : loadGenerator.cpp
+// @brief : headless load generator with poisson / bursty arrivals
+// @author: August
+// @date  : 2025-06-16
+#include "loadGenerator.h"
+#include "../managers/playerManager.h"
+#include "../managers/battleManager.h"
+#include "../managers/clockManager.h"
+#include "../../utils/utils.h"
+#include "../../utils/histogram.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+const double LOAD_BURST_MEAN_SIZE = 20.0;                           // mean players per group of ArrivalBursty
+const std::chrono::seconds LOAD_SAMPLE_INTERVAL(1);                 // queue depth sampling
+const uint32_t LOAD_REPORT_SAMPLES = 10;                            // a report line every 10 samples
+
+// counters shared by the arrival threads
+struct LoadCounters
+{
+	std::atomic<uint64_t> m_arrivals = 0;   // login attempts
+	std::atomic<uint64_t> m_joined = 0;     // players put into the queue
+	std::atomic<uint64_t> m_busy = 0;       // players already queued or in a battle
+	std::atomic<uint64_t> m_failed = 0;     // login failed
+};
+
+// exponential random number with the given mean
+static double getExponential(double mean)
+{
+    return -std::log(1.0 - random_utils::getRandomUnit()) * mean;
+}
+
+// geometric random number >= 1 with the given mean
+static uint32_t getGeometric(double mean)
+{
+    const double p = 1.0 / mean;
+    return 1 + static_cast<uint32_t>(std::floor(std::log(1.0 - random_utils::getRandomUnit()) / std::log(1.0 - p)));
+}
+
+// the players of the run, any ids (not necessarily 1..n)
+static void joinRandomPlayer(const std::vector<uint64_t>& refVecIds, LoadCounters& refCounters)
+{
+    refCounters.m_arrivals.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t id = refVecIds[random_utils::getRandomRange<size_t>(0, refVecIds.size() - 1)];
+    Player* pPlayer = PlayerManager::instance().playerLogin(id);
+    if (!pPlayer)
+    {
+        refCounters.m_failed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!pPlayer->isInLobby())
+    {
+        refCounters.m_busy.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    BattleManager::instance().addPlayerToQueue(pPlayer);
+    refCounters.m_joined.fetch_add(1, std::memory_order_relaxed);
+}
+
+// one arrival thread, the arrival times are absolute so a slow login does not lower the rate
+static void arrivalThread(const LoadGeneratorOptions& refOptions, ClockManager::TimePoint endTime, const std::vector<uint64_t>& refVecIds, LoadCounters& refCounters)
+{
+    ClockManager& refClock = ClockManager::instance();
+	refClock.attachThread();    // virtual time waits for the arrivals
+
+    const bool isBursty = (refOptions.m_arrival == load::ArrivalProcess::ArrivalBursty);
+    const double threadRate = static_cast<double>(refOptions.m_rate) / refOptions.m_threads;
+    const double meanGapSec = (isBursty ? LOAD_BURST_MEAN_SIZE : 1.0) / threadRate;
+
+    auto nextTime = refClock.now();
+    while (true)
+    {
+        nextTime += std::chrono::duration_cast<ClockManager::Duration>(std::chrono::duration<double>(getExponential(meanGapSec)));
+        if (nextTime >= endTime)
+        {
+            break;
+        }
+        const auto now = refClock.now();
+        if (nextTime > now)
+        {
+            refClock.sleepFor(nextTime - now);
+        }
+
+        const uint32_t groupSize = isBursty ? getGeometric(LOAD_BURST_MEAN_SIZE) : 1;
+        for (uint32_t i = 0; i < groupSize; i++)
+        {
+            joinRandomPlayer(refVecIds, refCounters);
+        }
+    }
+    refClock.detachThread();
+}
+
+void runLoadGenerator(const LoadGeneratorOptions& refOptions)
+{
+    ClockManager& refClock = ClockManager::instance();
+    BattleManager& refBattle = BattleManager::instance();
+    if (refOptions.m_rate == 0 || refOptions.m_threads == 0)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Load generator needs a rate and threads."
+            << std::endl;
+        return;
+    }
+
+	// draw from the loaded players, create the missing ones (a fresh db has none)
+    std::vector<uint64_t> vecIds;
+    PlayerManager::instance().getPlayerIds(vecIds);
+    if (refOptions.m_players > 0 && vecIds.size() > refOptions.m_players)
+    {
+        vecIds.resize(refOptions.m_players);
+    }
+    if (vecIds.size() < refOptions.m_players)
+    {
+        const size_t createCounts = refOptions.m_players - vecIds.size();
+        std::cout << "[LoadGenerator] creating " << createCounts << " players...\n";
+        for (size_t i = 0; i < createCounts; i++)
+        {
+            Player* pPlayer = PlayerManager::instance().playerLogin(0);
+            if (!pPlayer)
+            {
+                break;
+            }
+            vecIds.emplace_back(pPlayer->getId());
+        }
+    }
+    if (vecIds.empty())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Load generator needs players, start it with --load-players=<n> on an empty db."
+            << std::endl;
+        return;
+    }
+
+    std::cout << "--- Load Generator : " << ((refOptions.m_arrival == load::ArrivalProcess::ArrivalBursty) ? "bursty" : "poisson")
+        << " arrivals, " << refOptions.m_rate << " players/s, " << refOptions.m_threads << " threads, " << refOptions.m_seconds << " s of "
+        << (refClock.isVirtual() ? "virtual" : "real") << " time, " << vecIds.size() << " players ---\n";
+
+    LoadCounters counters;
+    refBattle.setAutoRequeue(true);
+    refBattle.resetWaitStats();
+    const uint64_t beginBattles = refBattle.getStartedBattles();
+    const auto realBeginTime = std::chrono::steady_clock::now();
+
+	// the sampler is a participant too, the virtual time stops at every sample
+    refClock.attachThread();
+    const auto beginTime = refClock.now();
+    const auto endTime = beginTime + std::chrono::seconds(refOptions.m_seconds);
+    std::vector<std::thread> vecThreads;
+    for (uint32_t i = 0; i < refOptions.m_threads; i++)
+    {
+        vecThreads.emplace_back(arrivalThread, std::cref(refOptions), endTime, std::cref(vecIds), std::ref(counters));
+    }
+
+    uint64_t depthSamples = 0;
+    uint64_t depthSum = 0;
+    size_t depthMax = 0;
+    uint64_t lastBattles = beginBattles;
+    for (auto sampleTime = beginTime + LOAD_SAMPLE_INTERVAL; sampleTime <= endTime; sampleTime += LOAD_SAMPLE_INTERVAL)
+    {
+        refClock.sleepFor(sampleTime - refClock.now());
+        const size_t depth = refBattle.getQueuedPlayers();
+        depthSamples++;
+        depthSum += depth;
+        depthMax = std::max(depthMax, depth);
+        if (depthSamples % LOAD_REPORT_SAMPLES == 0)
+        {
+            const uint64_t battles = refBattle.getStartedBattles();
+            std::cout << "[LoadGenerator] " << std::setw(6) << depthSamples << " s : " << counters.m_joined.load() << " joined, "
+                << (battles - beginBattles) << " matches (" << std::fixed << std::setprecision(1)
+                << static_cast<double>(battles - lastBattles) / LOAD_REPORT_SAMPLES << "/s), queue " << depth
+                << ", wait p99 " << refBattle.getQueueWaitHistogram().getPercentile(99.0) / 1000.0 << " ms\n";
+            std::cout.unsetf(std::ios::fixed);
+            lastBattles = battles;
+        }
+    }
+    refClock.detachThread();
+    for (auto& thread : vecThreads)
+    {
+        thread.join();
+    }
+    refBattle.setAutoRequeue(false);
+
+    const double simSeconds = std::chrono::duration<double>(refClock.now() - beginTime).count();
+    const double realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - realBeginTime).count();
+    const uint64_t matches = refBattle.getStartedBattles() - beginBattles;
+    const LatencyHistogram& refWait = refBattle.getQueueWaitHistogram();
+
+    std::cout << "\n--- Load Generator Report ---\n" << std::fixed << std::setprecision(2);
+    std::cout << "  duration       : " << simSeconds << " s (" << realSeconds << " s real)\n";
+    std::cout << "  arrivals       : " << counters.m_arrivals.load() << " (" << counters.m_joined.load() << " joined, "
+        << counters.m_busy.load() << " already queued or in battle, " << counters.m_failed.load() << " failed)\n";
+    std::cout << "  arrival rate   : " << ((simSeconds > 0.0) ? counters.m_arrivals.load() / simSeconds : 0.0) << " /s\n";
+    std::cout << "  matches        : " << matches << " (" << ((simSeconds > 0.0) ? matches / simSeconds : 0.0) << " /s)\n";
+    std::cout << "  queue depth    : avg " << ((depthSamples > 0) ? static_cast<double>(depthSum) / depthSamples : 0.0) << ", max " << depthMax << "\n";
+    std::cout << "  queue wait ms  : p50 " << refWait.getPercentile(50.0) / 1000.0 << ", p90 " << refWait.getPercentile(90.0) / 1000.0
+        << ", p99 " << refWait.getPercentile(99.0) / 1000.0 << ", max " << refWait.getMax() / 1000.0
+        << " (" << refWait.getCount() << " players)\n";
+    std::cout << "-----------------------------\n";
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,22 @@
+// loadGenerator.h
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <cstdint>
+#include "../../include/globalDefine.h"
+
+struct LoadGeneratorOptions
+{
+	load::ArrivalProcess m_arrival = load::ArrivalProcess::ArrivalPoisson;
+	uint32_t m_rate = 1000;         // target player arrivals per second over all threads
+	uint32_t m_seconds = 60;        // run time, simulated seconds with the virtual clock
+	uint32_t m_threads = 4;         // arrival threads, each drives rate / threads
+	uint32_t m_players = 0;         // players to draw the arrivals from, created first if fewer are loaded (0 : all loaded players)
+};
+
+// headless load run against the started server : arrival threads log random players of the loaded set in and queue them,
+// players join the queue again after their battle, a report line every 10 seconds and a summary at the end
+// (matches/sec, queue depth, queue wait percentiles)
+void runLoadGenerator(const LoadGeneratorOptions& refOptions);
+
+#endif // LOAD_GENERATOR_H
@@ -0,0 +1,266 @@
+// @file  : matchmakingBench.cpp
+// @brief : end-to-end matchmaking benchmark with JSON output
+// @author: August
+// @date  : 2025-06-16
+#include "matchmakingBench.h"
+#include "../managers/playerManager.h"
+#include "../managers/battleManager.h"
+#include "../managers/scheduleManager.h"
+#include "../managers/executorManager.h"
+#include "../managers/clockManager.h"
+#include "../managers/logManager.h"
+#include "../stores/memoryPlayerStore.h"
+#include "../../include/globalDefine.h"
+#include "../../utils/utils.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+const size_t MATCHMAKING_BENCH_COUNTS[] = { 10000, 100000, 1000000 };
+const size_t MATCHMAKING_BENCH_MAX_PLAYERS = 1000000;
+const char* MATCHMAKING_BENCH_JSON_NAME = "bench_matchmaking.json";
+const std::chrono::seconds MATCHMAKING_BENCH_TIMEOUT(600);          // one round gives up after this
+const std::chrono::milliseconds MATCHMAKING_BENCH_POLL(1);
+
+// one round of the benchmark
+struct MatchmakingBenchResult
+{
+    size_t m_queuedPlayers = 0;
+    double m_enqueuePerSec = 0.0;       // addPlayerToQueue calls per second, matchmaking stopped
+    uint64_t m_expectedRooms = 0;       // full rooms the queued players can form (6 players of one tier)
+    uint64_t m_rooms = 0;               // rooms created in the round
+    double m_matchSeconds = 0.0;        // from starting the matchmaking to the last room
+    double m_roomsPerSec = 0.0;
+    uint64_t m_waitP50Us = 0;           // addPlayerToQueue to BattleRoom creation
+    uint64_t m_waitP99Us = 0;
+    uint64_t m_waitP999Us = 0;
+    uint64_t m_waitMaxUs = 0;
+    uint64_t m_peakRssBytes = 0;        // of the process so far
+    bool m_isTimeout = false;
+};
+
+// peak resident set size of the process, 0 where not supported
+static uint64_t getPeakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);          // bytes
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+#endif
+}
+
+// nearest-rank percentile of sorted samples, 0 if empty
+static uint64_t getSortedPercentile(const std::vector<uint64_t>& refVecSorted, double percentile)
+{
+    if (refVecSorted.empty())
+    {
+        return 0;
+    }
+    const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * refVecSorted.size()));
+    return refVecSorted[std::min(std::max<size_t>(rank, 1), refVecSorted.size()) - 1];
+}
+
+// wait until refIsDone returns true, false after the timeout
+template <typename IsDoneFunc>
+static bool waitFor(IsDoneFunc refIsDone)
+{
+    const auto deadline = std::chrono::steady_clock::now() + MATCHMAKING_BENCH_TIMEOUT;
+    while (!refIsDone())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(MATCHMAKING_BENCH_POLL);
+    }
+    return true;
+}
+
+static void runOneRound(size_t playerCounts, MatchmakingBenchResult& refResult)
+{
+    BattleManager& refBattle = BattleManager::instance();
+    PlayerManager& refPlayer = PlayerManager::instance();
+    refResult.m_queuedPlayers = playerCounts;
+
+	// players of the round, logged in beforehand (not timed), all back in the lobby after the previous round
+    std::vector<Player*> vecPlayers;
+    vecPlayers.reserve(playerCounts);
+    uint64_t arrTierCounts[battle::Tier::TierMax + 1] = {};
+    for (uint64_t id = 1; id <= playerCounts; id++)
+    {
+        Player* pPlayer = refPlayer.playerLogin(id);
+        if (pPlayer && pPlayer->isInLobby())
+        {
+            vecPlayers.emplace_back(pPlayer);
+            arrTierCounts[pPlayer->getTier()]++;
+        }
+    }
+    for (uint64_t tierCounts : arrTierCounts)
+    {
+		// 3 players a team, 2 teams a room
+        refResult.m_expectedRooms += tierCounts / battle::TeamMembers::TeamMemberMax / battle::TeamColor::TeamColorMax;
+    }
+
+	// enqueue with the matchmaking stopped, the whole batch is queued when it starts
+    refBattle.resetWaitStats();
+    auto beginTime = std::chrono::steady_clock::now();
+    for (Player* pPlayer : vecPlayers)
+    {
+        refBattle.addPlayerToQueue(pPlayer);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+    refResult.m_enqueuePerSec = (sec > 0.0) ? (vecPlayers.size() / sec) : 0.0;
+
+	// drain the queue, every wait is kept for exact percentiles
+    const uint64_t beginRooms = refBattle.getStartedBattles();
+    refBattle.setQueueWaitSampling(true);
+    beginTime = std::chrono::steady_clock::now();
+    refBattle.startMatchmaking();
+    refResult.m_isTimeout = !waitFor([&]() { return refBattle.getStartedBattles() - beginRooms >= refResult.m_expectedRooms; });
+    sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+    refBattle.stopMatchmaking();
+
+    refResult.m_rooms = refBattle.getStartedBattles() - beginRooms;
+    refResult.m_matchSeconds = sec;
+    refResult.m_roomsPerSec = (sec > 0.0) ? (refResult.m_rooms / sec) : 0.0;
+    std::vector<uint64_t> vecWaits;
+    refBattle.takeQueueWaitSamples(vecWaits);
+    refBattle.setQueueWaitSampling(false);
+    std::sort(vecWaits.begin(), vecWaits.end());
+    refResult.m_waitP50Us = getSortedPercentile(vecWaits, 50.0);
+    refResult.m_waitP99Us = getSortedPercentile(vecWaits, 99.0);
+    refResult.m_waitP999Us = getSortedPercentile(vecWaits, 99.9);
+    refResult.m_waitMaxUs = vecWaits.empty() ? 0 : vecWaits.back();
+    refResult.m_peakRssBytes = getPeakRssBytes();
+
+	// let the battles end so the players are in the lobby for the next round, the left-overs leave the queue
+    waitFor([&]() { return refBattle.getFinishedBattles() >= refBattle.getStartedBattles(); });
+    refBattle.clearQueues();
+}
+
+static std::string toJson(const std::vector<MatchmakingBenchResult>& refVecResults)
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "{\n";
+    oss << "  \"benchmark\": \"matchmaking\",\n";
+    oss << "  \"executor_threads\": " << ExecutorManager::instance().getThreadCounts() << ",\n";
+    oss << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    oss << "  \"clock\": \"" << (ClockManager::instance().isVirtual() ? "virtual" : "real") << "\",\n";
+    oss << "  \"rounds\": [\n";
+    for (size_t i = 0; i < refVecResults.size(); i++)
+    {
+        const MatchmakingBenchResult& refResult = refVecResults[i];
+        oss << "    {\n";
+        oss << "      \"queued_players\": " << refResult.m_queuedPlayers << ",\n";
+        oss << "      \"enqueue_per_sec\": " << refResult.m_enqueuePerSec << ",\n";
+        oss << "      \"expected_rooms\": " << refResult.m_expectedRooms << ",\n";
+        oss << "      \"rooms\": " << refResult.m_rooms << ",\n";
+        oss << "      \"match_seconds\": " << std::setprecision(3) << refResult.m_matchSeconds << std::setprecision(1) << ",\n";
+        oss << "      \"rooms_per_sec\": " << refResult.m_roomsPerSec << ",\n";
+        oss << "      \"wait_us\": { \"p50\": " << refResult.m_waitP50Us << ", \"p99\": " << refResult.m_waitP99Us
+            << ", \"p999\": " << refResult.m_waitP999Us << ", \"max\": " << refResult.m_waitMaxUs << " },\n";
+        oss << "      \"peak_rss_bytes\": " << refResult.m_peakRssBytes << ",\n";
+        oss << "      \"timeout\": " << (refResult.m_isTimeout ? "true" : "false") << "\n";
+        oss << "    }" << ((i + 1 < refVecResults.size()) ? "," : "") << "\n";
+    }
+    oss << "  ]\n";
+    oss << "}\n";
+    return oss.str();
+}
+
+void runMatchmakingBenchmark()
+{
+    std::cout << "--- Matchmaking Benchmark (memory store, up to " << MATCHMAKING_BENCH_MAX_PLAYERS << " queued players) ---\n";
+
+	// battle lines of every room would flood the log
+    const logging::LogLevel orgLogLevel = LogManager::instance().getLevel();
+    LogManager::instance().setLevel(logging::LogLevel::LogLevelWarning);
+
+    if (!PlayerManager::instance().initialize() || !BattleManager::instance().initialize() || !ScheduleManager::instance().initialize())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to initialize the managers."
+            << std::endl;
+        LogManager::instance().setLevel(orgLogLevel);
+        return;
+    }
+
+	// players spread over all tiers
+    std::unique_ptr<PlayerStore> uPlayerStore = std::make_unique<MemoryPlayerStore>();
+    uPlayerStore->open();
+    for (size_t i = 0; i < MATCHMAKING_BENCH_MAX_PLAYERS; i++)
+    {
+        PlayerRecord record{ 0, random_utils::getRandom(battle::TIER_SCORE_INTERVAL * battle::TIER_MAX), 0, 1 };
+        uPlayerStore->insert(record);
+    }
+    PlayerStore* pPlayerStore = uPlayerStore.get();
+    PlayerManager::instance().setPlayerStore(std::move(uPlayerStore));
+    pPlayerStore->loadAll();
+
+	// passes back to back, virtual time only moves while the matchmaking thread sleeps
+    BattleManager::instance().setMatchmakingInterval(std::chrono::milliseconds(ClockManager::instance().isVirtual() ? 1 : 0));
+
+    std::vector<MatchmakingBenchResult> vecResults;
+    for (size_t playerCounts : MATCHMAKING_BENCH_COUNTS)
+    {
+        MatchmakingBenchResult result;
+        runOneRound(playerCounts, result);
+        vecResults.emplace_back(result);
+        std::cout << "[MatchmakingBench] " << std::setw(8) << playerCounts << " players : " << result.m_rooms << " rooms in "
+            << std::fixed << std::setprecision(3) << result.m_matchSeconds << " s" << (result.m_isTimeout ? " (timeout)" : "") << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    BattleManager::instance().setMatchmakingInterval(std::chrono::milliseconds(100));
+    BattleManager::instance().release();
+    ScheduleManager::instance().release();
+    PlayerManager::instance().release();
+    LogManager::instance().setLevel(orgLogLevel);
+
+    const std::string json = toJson(vecResults);
+    std::cout << json;
+    std::ofstream file(MATCHMAKING_BENCH_JSON_NAME, std::ios::trunc);
+    if (!file || !(file << json))
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to write " << MATCHMAKING_BENCH_JSON_NAME
+            << std::endl;
+        return;
+    }
+    std::cout << "Results written to " << MATCHMAKING_BENCH_JSON_NAME << "\n";
+}
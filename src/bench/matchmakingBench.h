@@ -0,0 +1,10 @@
+// matchmakingBench.h
+#ifndef MATCHMAKING_BENCH_H
+#define MATCHMAKING_BENCH_H
+
+// end-to-end matchmaking with 10k, 100k and 1M queued players on the in-process managers (memory player store) :
+// enqueue throughput, queue wait until the battle room is created (p50/p99/p999), rooms formed per second and peak RSS
+// the results are written as JSON to stdout and "bench_matchmaking.json" to be diffed between versions
+void runMatchmakingBenchmark();
+
+#endif // MATCHMAKING_BENCH_H
@@ -0,0 +1,264 @@
+// @file  : microBench.cpp
+// @brief : microbenchmarks of the core data structures
+// @author: August
+// @date  : 2025-06-16
+#include "microBench.h"
+#include "../managers/battleManager.h"
+#include "../managers/playerManager.h"
+#include "../managers/dbManager.h"
+#include "../managers/logManager.h"
+#include "../stores/memoryPlayerStore.h"
+#include "../objects/player.h"
+#include "../../include/globalDefine.h"
+#include "../../utils/utils.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <cstdio>
+#include <iterator>
+
+const uint32_t MICRO_BENCH_THREAD_COUNTS[] = { 1, 2, 4, 8 };
+const std::chrono::milliseconds MICRO_BENCH_MIN_TIME(200);     // a run shorter than this is repeated with doubled iterations
+const uint64_t MICRO_BENCH_MAX_ITERATIONS = 1ULL << 30;
+const uint64_t MICRO_BENCH_PLAYERS = 100000;                    // players of PlayerManager (getTopPlayers sorts all of them)
+const uint64_t MICRO_BENCH_DB_PLAYERS = 10000;                  // rows of the database
+const size_t MICRO_BENCH_QUEUE_PLAYERS = 3000;                  // players pushed by one thread, reused
+const char* MICRO_BENCH_DB_NAME = "bench_micro.db";
+
+// one benchmark, funcRun(threadIndex, iterations) runs the operation iterations times on the calling thread
+struct MicroBenchCase
+{
+    std::string m_name;
+    std::function<void(uint32_t, uint64_t)> m_funcRun;
+};
+
+static std::atomic<uint64_t> s_checksum = 0;   // keeps the results from being optimized away
+
+// run funcRun on threadCounts threads, returns the wall time
+static std::chrono::steady_clock::duration runThreads(const MicroBenchCase& refCase, uint32_t threadCounts, uint64_t iterations)
+{
+    std::vector<std::thread> vecThreads;
+    const auto beginTime = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < threadCounts; i++)
+    {
+        vecThreads.emplace_back(refCase.m_funcRun, i, iterations);
+    }
+    for (auto& thread : vecThreads)
+    {
+        thread.join();
+    }
+    return std::chrono::steady_clock::now() - beginTime;
+}
+
+// one line of the result table
+static void runCase(const MicroBenchCase& refCase, uint32_t threadCounts)
+{
+    uint64_t iterations = 1;
+    std::chrono::steady_clock::duration elapsed{};
+    while (true)
+    {
+        elapsed = runThreads(refCase, threadCounts, iterations);
+        if (elapsed >= MICRO_BENCH_MIN_TIME || iterations >= MICRO_BENCH_MAX_ITERATIONS)
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    const uint64_t totalOps = iterations * threadCounts;
+
+    std::cout << std::left << std::setw(54) << (refCase.m_name + "/threads:" + std::to_string(threadCounts)) << std::right
+        << std::fixed << std::setprecision(1) << std::setw(14) << (ns / totalOps) << " ns"
+        << std::setprecision(0) << std::setw(14) << (totalOps / ns * 1000000000.0) << " /s"
+        << std::setw(14) << iterations << "\n";
+    std::cout.unsetf(std::ios::fixed);
+}
+
+// players of the queue benchmarks, one tier per thread
+static std::vector<std::vector<std::unique_ptr<Player>>> createQueuePlayers()
+{
+    std::vector<std::vector<std::unique_ptr<Player>>> vecThreadPlayers(MICRO_BENCH_THREAD_COUNTS[std::size(MICRO_BENCH_THREAD_COUNTS) - 1]);
+    uint64_t id = 1;
+    for (size_t t = 0; t < vecThreadPlayers.size(); t++)
+    {
+        const uint32_t score = static_cast<uint32_t>(t % battle::TIER_MAX) * battle::TIER_SCORE_INTERVAL;
+        for (size_t i = 0; i < MICRO_BENCH_QUEUE_PLAYERS; i++)
+        {
+            vecThreadPlayers[t].emplace_back(std::make_unique<Player>(id++, score, 0, 0));
+        }
+    }
+    return vecThreadPlayers;
+}
+
+static bool openBenchDb()
+{
+    std::remove(MICRO_BENCH_DB_NAME);
+    DbManager& refDb = DbManager::instance();
+    refDb.configure(MICRO_BENCH_DB_NAME, 1);
+    if (!refDb.initialize() || !refDb.connect() || !refDb.ensureTableSchema())
+    {
+        refDb.release();
+        return false;
+    }
+    std::vector<PlayerRecord> vecRecords(MICRO_BENCH_DB_PLAYERS);
+    for (auto& record : vecRecords)
+    {
+        record.m_score = random_utils::getRandom(battle::TIER_SCORE_INTERVAL * battle::TIER_MAX);
+        record.m_updatedTime = 1;
+    }
+    return refDb.insertPlayerBattlesBatch(vecRecords);
+}
+
+static void closeBenchDb()
+{
+    DbManager::instance().release();
+    std::remove(MICRO_BENCH_DB_NAME);
+    std::remove((std::string(MICRO_BENCH_DB_NAME) + "-journal").c_str());
+    std::remove((std::string(MICRO_BENCH_DB_NAME) + "-wal").c_str());
+    std::remove((std::string(MICRO_BENCH_DB_NAME) + "-shm").c_str());
+}
+
+void runMicroBenchmark()
+{
+    std::cout << "--- Micro Benchmark (time per operation over all threads, min " << MICRO_BENCH_MIN_TIME.count() << " ms a run) ---\n";
+
+	// debug lines of the queues stay out of the numbers
+    const logging::LogLevel orgLogLevel = LogManager::instance().getLevel();
+    LogManager::instance().setLevel(logging::LogLevel::LogLevelWarning);
+
+	// players spread over all tiers in a memory store
+    PlayerManager::instance().initialize();
+    std::unique_ptr<PlayerStore> uPlayerStore = std::make_unique<MemoryPlayerStore>();
+    uPlayerStore->open();
+    for (uint64_t i = 0; i < MICRO_BENCH_PLAYERS; i++)
+    {
+        PlayerRecord record{ 0, random_utils::getRandom(battle::TIER_SCORE_INTERVAL * battle::TIER_MAX), random_utils::getRandom(100U), 1 };
+        uPlayerStore->insert(record);
+    }
+    PlayerStore* pPlayerStore = uPlayerStore.get();
+    PlayerManager::instance().setPlayerStore(std::move(uPlayerStore));
+    pPlayerStore->loadAll();
+
+    const auto vecThreadPlayers = createQueuePlayers();
+    TeamMatchQueue teamQueue;
+    BattleMatchQueue battleQueue;
+    const bool isDbOpen = openBenchDb();
+
+    std::vector<MicroBenchCase> vecCases;
+    vecCases.push_back({ "TeamMatchQueue/addMember+getPlayersForTeam", [&](uint32_t threadIndex, uint64_t iterations) {
+		// a team is popped after every 3 pushes
+        const auto& refVecPlayers = vecThreadPlayers[threadIndex];
+        const uint32_t tier = refVecPlayers[0]->getTier();
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            teamQueue.addMember(refVecPlayers[i % refVecPlayers.size()].get());
+            if (i % battle::TeamMembers::TeamMemberMax == battle::TeamMembers::TeamMemberMax - 1)
+            {
+                sum += teamQueue.getPlayersForTeam(tier).size();
+            }
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+    vecCases.push_back({ "BattleMatchQueue/addTeam+getTeamsForBattle", [&](uint32_t threadIndex, uint64_t iterations) {
+        const auto& refVecPlayers = vecThreadPlayers[threadIndex];
+        const uint32_t tier = refVecPlayers[0]->getTier();
+        const std::vector<Player*> vecTeam = { refVecPlayers[0].get(), refVecPlayers[1].get(), refVecPlayers[2].get() };
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            battleQueue.addTeam(vecTeam);
+            if (i % battle::TeamColor::TeamColorMax == battle::TeamColor::TeamColorMax - 1)
+            {
+                sum += battleQueue.getTeamsForBattle(tier).size();
+            }
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+    vecCases.push_back({ "PlayerManager/getPlayer", [](uint32_t, uint64_t iterations) {
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sum += (PlayerManager::instance().getPlayer(random_utils::getRandomRange<uint64_t>(1, MICRO_BENCH_PLAYERS)) != nullptr);
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+    vecCases.push_back({ "PlayerManager/playerLogin", [](uint32_t, uint64_t iterations) {
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sum += (PlayerManager::instance().playerLogin(random_utils::getRandomRange<uint64_t>(1, MICRO_BENCH_PLAYERS)) != nullptr);
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+    vecCases.push_back({ "PlayerManager/getTopPlayers(10)", [](uint32_t, uint64_t iterations) {
+		// the sorting of the "top" command
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sum += PlayerManager::instance().getTopPlayers(10).size();
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+    vecCases.push_back({ "Player/getTier", [&](uint32_t threadIndex, uint64_t iterations) {
+        const auto& refVecPlayers = vecThreadPlayers[threadIndex];
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sum += refVecPlayers[i % refVecPlayers.size()]->getTier();
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+    if (isDbOpen)
+    {
+        vecCases.push_back({ "DbManager/updatePlayerBattles", [](uint32_t, uint64_t iterations) {
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                sum += DbManager::instance().updatePlayerBattles(random_utils::getRandomRange<uint64_t>(1, MICRO_BENCH_DB_PLAYERS),
+                    random_utils::getRandom(battle::TIER_SCORE_INTERVAL * battle::TIER_MAX), static_cast<uint32_t>(i));
+            }
+            s_checksum.fetch_add(sum, std::memory_order_relaxed);
+        } });
+    }
+    else
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to open " << MICRO_BENCH_DB_NAME << ", DbManager/updatePlayerBattles skipped."
+            << std::endl;
+    }
+    vecCases.push_back({ "random_utils/getRandom", [](uint32_t, uint64_t iterations) {
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sum += random_utils::getRandom(100U);
+        }
+        s_checksum.fetch_add(sum, std::memory_order_relaxed);
+    } });
+
+    std::cout << std::left << std::setw(54) << "Benchmark" << std::right << std::setw(17) << "Time" << std::setw(17) << "Rate" << std::setw(14) << "Iterations" << "\n";
+    std::cout << std::string(102, '-') << "\n";
+    for (const auto& refCase : vecCases)
+    {
+        for (uint32_t threadCounts : MICRO_BENCH_THREAD_COUNTS)
+        {
+            runCase(refCase, threadCounts);
+            teamQueue.clear();
+            battleQueue.clear();
+        }
+    }
+    std::cout << std::string(102, '-') << "\n";
+    std::cout << "(checksum " << s_checksum.load() << ")\n";
+
+    closeBenchDb();
+    PlayerManager::instance().release();
+    LogManager::instance().setLevel(orgLogLevel);
+}
@@ -0,0 +1,12 @@
+// microBench.h
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+// isolated operations of the core classes at 1, 2, 4 and 8 threads :
+// TeamMatchQueue / BattleMatchQueue push and pop, PlayerManager getPlayer / playerLogin / getTopPlayers,
+// Player::getTier, DbManager::updatePlayerBattles and random_utils::getRandom
+// every case is repeated with doubled iterations until one run takes long enough (like Google Benchmark),
+// uses its own database file ("bench_micro.db"), which is removed afterwards
+void runMicroBenchmark();
+
+#endif // MICRO_BENCH_H
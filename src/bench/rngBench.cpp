@@ -0,0 +1,95 @@
+// @file  : rngBench.cpp
+// @brief : throughput of the random number generators
+// @author: August
+// @date  : 2025-06-14
+#include "rngBench.h"
+#include "../../utils/utils.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+const uint32_t RNG_BENCH_THREAD_COUNTS[] = { 1, 2, 4, 8 };
+const uint64_t RNG_BENCH_DRAWS = 4000000;           // numbers drawn by each thread
+const uint32_t RNG_BENCH_RANGE = 100;               // like the battle dice and score rolls
+
+// one line of the result table (million numbers per second over all threads)
+struct RngBenchResult
+{
+    uint32_t m_threadCounts = 0;
+    double m_sharedMtPerSec = 0.0;
+    double m_threadMtPerSec = 0.0;
+    double m_threadXoshiroPerSec = 0.0;
+};
+
+static std::mutex s_sharedMutex;
+static std::mt19937 s_sharedGenerator(std::random_device{}());
+
+// run drawFunc RNG_BENCH_DRAWS times on each thread, returns million draws per second
+template <typename DrawFunc>
+static double runThreads(uint32_t threadCounts, DrawFunc drawFunc)
+{
+    std::atomic<uint64_t> checksum = 0;     // keeps the draws from being optimized away
+    std::vector<std::thread> vecThreads;
+    const auto beginTime = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < threadCounts; i++)
+    {
+        vecThreads.emplace_back([&drawFunc, &checksum]() {
+            uint64_t sum = 0;
+            for (uint64_t n = 0; n < RNG_BENCH_DRAWS; n++)
+            {
+                sum += drawFunc();
+            }
+            checksum.fetch_add(sum);
+        });
+    }
+    for (auto& thread : vecThreads)
+    {
+        thread.join();
+    }
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - beginTime).count();
+    return (sec > 0.0 && checksum.load() != 0) ? (RNG_BENCH_DRAWS * threadCounts / sec / 1000000.0) : 0.0;
+}
+
+void runRngBenchmark()
+{
+    std::cout << "--- RNG Benchmark (" << RNG_BENCH_DRAWS << " numbers in [0, " << RNG_BENCH_RANGE << ") per thread, M numbers/s) ---\n";
+
+    std::vector<RngBenchResult> vecResults;
+    for (uint32_t threadCounts : RNG_BENCH_THREAD_COUNTS)
+    {
+        RngBenchResult result;
+        result.m_threadCounts = threadCounts;
+        result.m_sharedMtPerSec = runThreads(threadCounts, []() {
+            std::uniform_int_distribution<uint32_t> distrib(0, RNG_BENCH_RANGE - 1);
+            std::lock_guard<std::mutex> lock(s_sharedMutex);
+            return distrib(s_sharedGenerator);
+        });
+        result.m_threadMtPerSec = runThreads(threadCounts, []() {
+            static thread_local std::mt19937 t_generator(std::random_device{}());
+            std::uniform_int_distribution<uint32_t> distrib(0, RNG_BENCH_RANGE - 1);
+            return distrib(t_generator);
+        });
+        result.m_threadXoshiroPerSec = runThreads(threadCounts, []() {
+            return random_utils::getRandom(RNG_BENCH_RANGE);
+        });
+        vecResults.emplace_back(result);
+    }
+
+    std::cout << std::left << std::setw(10) << "threads"
+        << std::setw(20) << "shared mt19937"
+        << std::setw(20) << "thread mt19937"
+        << std::setw(20) << "thread xoshiro" << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& result : vecResults)
+    {
+        std::cout << std::left << std::setw(10) << result.m_threadCounts
+            << std::setw(20) << result.m_sharedMtPerSec
+            << std::setw(20) << result.m_threadMtPerSec
+            << std::setw(20) << result.m_threadXoshiroPerSec << "\n";
+    }
+}
@@ -0,0 +1,10 @@
+// rngBench.h
+#ifndef RNG_BENCH_H
+#define RNG_BENCH_H
+
+// throughput of random_utils::getRandom with 1, 2, 4 and 8 threads
+// compared with the former shared std::mt19937 (behind a mutex, as it needs one to be thread-safe)
+// and a per-thread std::mt19937 with std::uniform_int_distribution
+void runRngBenchmark();
+
+#endif // RNG_BENCH_H
@@ -0,0 +1,163 @@
+// @file  : shardBench.cpp
+// @brief : throughput of player_battles over database shards
+// @author: August
+// @date  : 2025-06-11
+#include "shardBench.h"
+#include "../managers/dbManager.h"
+#include "../objects/player.h"
+#include "../../include/globalDefine.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+const uint32_t SHARD_BENCH_COUNTS[] = { 1, 2, 4, 8 };
+const uint32_t SHARD_BENCH_MAX_SHARDS = 8;
+const char* SHARD_BENCH_DB_NAME = "bench_shards.db";
+const size_t SHARD_BENCH_PLAYERS = 100000;          // players inserted before the rounds
+const size_t SHARD_BENCH_BATCH_SIZE = 5000;         // players updated (or queried) in one round
+const uint32_t SHARD_BENCH_ROUNDS = 20;
+
+// one line of the result table
+struct ShardBenchResult
+{
+    uint32_t m_shardCounts = 0;
+    double m_insertRowsPerSec = 0.0;
+    double m_updateRowsPerSec = 0.0;
+    double m_updateMsPerBatch = 0.0;
+    double m_queryRowsPerSec = 0.0;
+};
+
+static void removeBenchFiles()
+{
+    for (uint32_t i = 0; i < SHARD_BENCH_MAX_SHARDS; i++)
+    {
+        const std::string fileName = (i == 0) ? "bench_shards.db" : ("bench_shards.shard" + std::to_string(i) + ".db");
+        std::remove(fileName.c_str());
+        std::remove((fileName + "-journal").c_str());
+        std::remove((fileName + "-wal").c_str());
+        std::remove((fileName + "-shm").c_str());
+    }
+}
+
+static double perSec(size_t rows, std::chrono::steady_clock::duration elapsed)
+{
+    const double sec = std::chrono::duration<double>(elapsed).count();
+    return (sec > 0.0) ? (rows / sec) : 0.0;
+}
+
+static bool runOneShardCounts(uint32_t shardCounts, ShardBenchResult& refResult)
+{
+    removeBenchFiles();
+
+    DbManager& refDb = DbManager::instance();
+    refDb.configure(SHARD_BENCH_DB_NAME, shardCounts);
+    if (!refDb.initialize() || !refDb.connect() || !refDb.ensureTableSchema())
+    {
+        refDb.release();
+        return false;
+    }
+    refResult.m_shardCounts = shardCounts;
+
+    std::mt19937_64 rng(shardCounts);
+    std::uniform_int_distribution<uint32_t> scoreDist(0, 5000);
+
+	// seed players
+    std::vector<PlayerRecord> vecRecords(SHARD_BENCH_PLAYERS);
+    for (auto& record : vecRecords)
+    {
+        record.m_score = scoreDist(rng);
+        record.m_updatedTime = 1;
+    }
+    auto beginTime = std::chrono::steady_clock::now();
+    if (!refDb.insertPlayerBattlesBatch(vecRecords))
+    {
+        refDb.release();
+        return false;
+    }
+    refResult.m_insertRowsPerSec = perSec(vecRecords.size(), std::chrono::steady_clock::now() - beginTime);
+
+	// random dirty players, like the periodic save
+    const uint64_t firstId = vecRecords.front().m_id;
+    std::uniform_int_distribution<uint64_t> idDist(firstId, firstId + SHARD_BENCH_PLAYERS - 1);
+    std::vector<PlayerRecordUpdate> vecUpdates(SHARD_BENCH_BATCH_SIZE);
+    std::chrono::steady_clock::duration updateElapsed{};
+    for (uint32_t round = 0; round < SHARD_BENCH_ROUNDS; round++)
+    {
+        for (auto& update : vecUpdates)
+        {
+            update.m_record.m_id = idDist(rng);
+            update.m_record.m_score = scoreDist(rng);
+            update.m_record.m_wins = round;
+            update.m_dirtyMask = common::PlayerDirtyField::DirtyPersisted;
+        }
+        beginTime = std::chrono::steady_clock::now();
+        refDb.updatePlayerBattlesBatch(vecUpdates);
+        updateElapsed += std::chrono::steady_clock::now() - beginTime;
+    }
+    refResult.m_updateRowsPerSec = perSec(SHARD_BENCH_BATCH_SIZE * SHARD_BENCH_ROUNDS, updateElapsed);
+    refResult.m_updateMsPerBatch = std::chrono::duration<double, std::milli>(updateElapsed).count() / SHARD_BENCH_ROUNDS;
+
+	// random lookups, like preloading the players of a join command
+    std::vector<uint64_t> vecIds(SHARD_BENCH_BATCH_SIZE);
+    std::vector<PlayerRecord> vecFound;
+    std::chrono::steady_clock::duration queryElapsed{};
+    size_t queriedRows = 0;
+    for (uint32_t round = 0; round < SHARD_BENCH_ROUNDS; round++)
+    {
+        for (auto& id : vecIds)
+        {
+            id = idDist(rng);
+        }
+        vecFound.clear();
+        beginTime = std::chrono::steady_clock::now();
+        refDb.queryPlayerBattlesMany(vecIds, vecFound);
+        queryElapsed += std::chrono::steady_clock::now() - beginTime;
+        queriedRows += vecFound.size();
+    }
+    refResult.m_queryRowsPerSec = perSec(queriedRows, queryElapsed);
+
+    refDb.release();
+    return true;
+}
+
+void runShardBenchmark()
+{
+    std::cout << "--- Shard Benchmark (" << SHARD_BENCH_PLAYERS << " players, " << SHARD_BENCH_ROUNDS
+        << " rounds of " << SHARD_BENCH_BATCH_SIZE << " rows) ---\n";
+
+    std::vector<ShardBenchResult> vecResults;
+    for (uint32_t shardCounts : SHARD_BENCH_COUNTS)
+    {
+        ShardBenchResult result;
+        if (!runOneShardCounts(shardCounts, result))
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Benchmark failed with " << shardCounts << " shards."
+                << std::endl;
+            continue;
+        }
+        vecResults.emplace_back(result);
+    }
+    removeBenchFiles();
+
+    std::cout << std::left << std::setw(8) << "shards"
+        << std::setw(16) << "insert rows/s"
+        << std::setw(16) << "update rows/s"
+        << std::setw(16) << "ms/update batch"
+        << std::setw(16) << "query rows/s" << "\n";
+    std::cout << std::fixed << std::setprecision(0);
+    for (const auto& result : vecResults)
+    {
+        std::cout << std::left << std::setw(8) << result.m_shardCounts
+            << std::setw(16) << result.m_insertRowsPerSec
+            << std::setw(16) << result.m_updateRowsPerSec
+            << std::setprecision(2) << std::setw(16) << result.m_updateMsPerBatch << std::setprecision(0)
+            << std::setw(16) << result.m_queryRowsPerSec << "\n";
+    }
+}
@@ -0,0 +1,9 @@
+// shardBench.h
+#ifndef SHARD_BENCH_H
+#define SHARD_BENCH_H
+
+// write/read throughput of player_battles with 1, 2, 4 and 8 database shards
+// uses its own database files ("bench_shards*.db"), which are removed afterwards
+void runShardBenchmark();
+
+#endif // SHARD_BENCH_H
@@ -16,11 +16,46 @@
 #include "./managers/battleManager.h"
 #include "./managers/playerManager.h"
 #include "./managers/scheduleManager.h"
-#include "./managers/dbManager.h"
+#include "./managers/snapshotManager.h"
+#include "./managers/journalManager.h"
+#include "./managers/historyManager.h"
+#include "./managers/executorManager.h"
+#include "./managers/logManager.h"
+#include "./managers/clockManager.h"
+#include "./managers/metricsManager.h"
+#include "./managers/traceManager.h"
+#include "./stores/playerStore.h"
+#include "./bench/shardBench.h"
+#include "./bench/rngBench.h"
+#include "./bench/loadGenerator.h"
+#include "./bench/matchmakingBench.h"
+#include "./bench/microBench.h"
 #include "../utils/utils.h"
+#include "../utils/profiledMutex.h"
 
 std::atomic<bool> isRunning = true;
 
+// command line options
+struct LaunchOptions
+{
+	std::string m_storeType = "sqlite";     // --store=<sqlite|memory>
+	uint32_t m_dbShards = 1;                // --db-shards=<1..64>, database files of player_battles
+	std::string m_bench = "";               // --bench=<shards|rng|matchmaking|micro>, run a benchmark and exit
+	uint32_t m_threads = 0;                 // --threads=<0..256>, executor workers (0 : hardware concurrency)
+	bool m_isPinThreads = false;            // --pin-threads, pin executor workers to cpus
+	bool m_hasSeed = false;                 // --seed=<n> given
+	uint64_t m_seed = 0;                    // --seed=<n>, seed of the random numbers (battle results, scores)
+	logging::LogLevel m_logLevel = logging::LogLevel::LogLevelInfo;    // --log-level=<debug|info|warning|error>
+	timing::ClockMode m_clockMode = timing::ClockMode::ClockModeRealTime;  // --clock=<real|virtual>
+	uint32_t m_simSeconds = 0;              // --sim-seconds=<n>, run headless for n (simulated) seconds instead of reading commands
+	uint32_t m_simJoins = 100;              // --sim-joins=<1..100000>, players joining per (simulated) second
+	bool m_isLoad = false;                  // --load=<poisson|bursty> given, run the load generator instead of reading commands
+	LoadGeneratorOptions m_loadOptions{};   // --load, --load-rate=<1..1000000>, --load-seconds=<1..86400>, --load-threads=<1..64>, --load-players=<1..10000000>
+	uint16_t m_metricsPort = 0;             // --metrics-port=<1..65535>, serve /metrics on 127.0.0.1 (0 : off)
+};
+// parse command line options, returns false for unknown options
+bool parseLaunchOptions(int argc, char* argv[], LaunchOptions& refOptions);
+
 void commandThread();
 // display player status
 void showPlayer(Player* pPlayer, bool isList);
@@ -33,22 +68,91 @@ void listSpecPlayers(std::set<uint64_t> setPlayerIds);
 // simulate player matchmaking by ID
 void simulatePlayer(uint64_t playerId);
 // simulate a batch of players
-void simulateBatch(uint32_t counts);
+void simulateBatch(uint32_t counts, bool isVerbose = true);
+// headless run, a batch of players joins every (simulated) second
+void runSimulation(uint32_t simSeconds, uint32_t joinsPerSecond);
+// display battle history of a player
+void showPlayerHistory(uint64_t playerId, uint32_t counts);
+// display scheduled task statistics
+void showScheduleStats();
+// display queue gauges and wait times per tier
+void showMatchmakingStats();
+// display contention of the profiled locks
+void showLockStats();
 void exitGame();
 
-int main()
+int main(int argc, char* argv[])
 {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+    LaunchOptions launchOptions;
+    if (!parseLaunchOptions(argc, argv, launchOptions))
+    {
+        return 1;
+    }
+    if (launchOptions.m_hasSeed)
+    {
+		// before any thread draws a number
+        random_utils::setGlobalSeed(launchOptions.m_seed);
+    }
 
-    std::cout << "--- Game Match Demo Starting (Multithreaded Server) ---\n";
+	// logger first, every other manager may log
+    LogManager::instance().setLevel(launchOptions.m_logLevel);
+    if (!LogManager::instance().initialize())
+    {
+        std::cerr << "Error: Failed to initialize LogManager!\n";
+        return 1;
+    }
 
-	// initialize managers
-    if (!DbManager::instance().initialize())
+    if (!ClockManager::instance().initialize(launchOptions.m_clockMode))
     {
-        std::cerr << "Error: Failed to initialize DbManager!\n";
+        std::cerr << "Error: Failed to initialize ClockManager!\n";
         return 1;
     }
 
+	// shared executor first, the other managers submit to it
+    if (!ExecutorManager::instance().initialize(launchOptions.m_threads, launchOptions.m_isPinThreads))
+    {
+        std::cerr << "Error: Failed to initialize ExecutorManager!\n";
+        return 1;
+    }
+
+    if (launchOptions.m_bench == "shards")
+    {
+        runShardBenchmark();
+        ExecutorManager::instance().release();
+        ClockManager::instance().release();
+        LogManager::instance().release();
+        return 0;
+    }
+    if (launchOptions.m_bench == "rng")
+    {
+        runRngBenchmark();
+        ExecutorManager::instance().release();
+        ClockManager::instance().release();
+        LogManager::instance().release();
+        return 0;
+    }
+    if (launchOptions.m_bench == "matchmaking")
+    {
+        runMatchmakingBenchmark();
+        ExecutorManager::instance().release();
+        ClockManager::instance().release();
+        LogManager::instance().release();
+        return 0;
+    }
+    if (launchOptions.m_bench == "micro")
+    {
+        runMicroBenchmark();
+        ExecutorManager::instance().release();
+        ClockManager::instance().release();
+        LogManager::instance().release();
+        return 0;
+    }
+
+    std::cout << "--- Game Match Demo Starting (Multithreaded Server) ---\n";
+
+    const auto startupBeginTime = std::chrono::steady_clock::now();
+
+	// initialize managers
     if (!PlayerManager::instance().initialize())
     {
         std::cerr << "Error: Failed to initialize PlayerManager!\n";
@@ -67,24 +171,74 @@ int main()
         return 1;
     }
 
-	// connect to database
-    if (DbManager::instance().connect() == false)
+    if (!SnapshotManager::instance().initialize())
     {
-        std::cerr << "Error: Failed to connect to database!\n";
-		return 1;
+        std::cerr << "Error: Failed to initialize SnapshotManager!\n";
+        return 1;
+    }
+
+    if (!JournalManager::instance().initialize())
+    {
+        std::cerr << "Error: Failed to initialize JournalManager!\n";
+        return 1;
     }
-	// make sure the database schema is correct
-    if (DbManager::instance().ensureTableSchema() == false)
+
+    if (!HistoryManager::instance().initialize())
     {
-        std::cerr << "Error: Failed to ensure database schema!\n";
-		return 1;
+        std::cerr << "Error: Failed to initialize HistoryManager!\n";
+        return 1;
+    }
+
+    if (launchOptions.m_metricsPort > 0 && !MetricsManager::instance().initialize(launchOptions.m_metricsPort))
+    {
+        std::cerr << "Error: Failed to initialize MetricsManager!\n";
+        return 1;
+    }
+
+	// open player storage
+    std::unique_ptr<PlayerStore> uPlayerStore = createPlayerStore(launchOptions.m_storeType, launchOptions.m_dbShards);
+    if (!uPlayerStore || !uPlayerStore->open())
+    {
+        std::cerr << "Error: Failed to open player store '" << launchOptions.m_storeType << "'!\n";
+        return 1;
+    }
+    std::cout << "Player store : " << uPlayerStore->getName() << "\n";
+    PlayerStore* pPlayerStore = uPlayerStore.get();
+    PlayerManager::instance().setPlayerStore(std::move(uPlayerStore));
+
+    if (!pPlayerStore->loadAll())
+    {
+        std::cerr << "Error: Failed to load players from store '" << launchOptions.m_storeType << "'!\n";
+        return 1;
+    }
+    if (pPlayerStore->isPersistent())
+    {
+		JournalManager::instance().replayJournal();    // battle results not yet flushed before the last shutdown
+        if (JournalManager::instance().start() == false)
+        {
+            std::cerr << "Error: Failed to start battle result journal!\n";
+            return 1;
+        }
+		SnapshotManager::instance().markDataLoaded();  // player data is complete, snapshot can be written
+		HistoryManager::instance().start();            // battle history is only kept in db
     }
-	
-    DbManager::instance().loadTableData();
 
 	BattleManager::instance().startMatchmaking();   // startup matchmaking thread
 
-    std::cout << "Game Server initialized. Main thread ready for commands.\n";
+    const auto startupElapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startupBeginTime).count();
+    if (launchOptions.m_simSeconds > 0)
+    {
+        std::cout << "Game Server initialized in " << startupElapsedMs << " ms.\n";
+        runSimulation(launchOptions.m_simSeconds, launchOptions.m_simJoins);
+        exitGame();
+    }
+    if (launchOptions.m_isLoad)
+    {
+        std::cout << "Game Server initialized in " << startupElapsedMs << " ms.\n";
+        runLoadGenerator(launchOptions.m_loadOptions);
+        exitGame();
+    }
+    std::cout << "Game Server initialized in " << startupElapsedMs << " ms. Main thread ready for commands.\n";
     std::cout << "Type 'exit' to shut down the demo.\n";
 
 	std::thread cmdThread(commandThread);   // startup command thread
@@ -96,6 +250,99 @@ int main()
     return 0;
 }
 
+bool parseLaunchOptions(int argc, char* argv[], LaunchOptions& refOptions)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const size_t pos = arg.find('=');
+        const std::string key = arg.substr(0, pos);
+        const std::string value = (pos == std::string::npos) ? "" : arg.substr(pos + 1);
+
+        if (key == "--store" && (value == "sqlite" || value == "memory"))
+        {
+            refOptions.m_storeType = value;
+        }
+        else if (key == "--db-shards" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 2 && std::stoul(value) >= 1 && std::stoul(value) <= 64)
+        {
+            refOptions.m_dbShards = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--bench" && (value == "shards" || value == "rng" || value == "matchmaking" || value == "micro"))
+        {
+            refOptions.m_bench = value;
+        }
+        else if (key == "--threads" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 3 && std::stoul(value) <= 256)
+        {
+            refOptions.m_threads = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--pin-threads" && value.empty())
+        {
+            refOptions.m_isPinThreads = true;
+        }
+        else if (key == "--seed" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos && value.size() <= 19)
+        {
+            refOptions.m_hasSeed = true;
+            refOptions.m_seed = std::stoull(value);
+        }
+        else if (key == "--clock" && (value == "real" || value == "virtual"))
+        {
+            refOptions.m_clockMode = (value == "virtual") ? timing::ClockMode::ClockModeVirtual : timing::ClockMode::ClockModeRealTime;
+        }
+        else if (key == "--sim-seconds" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos && value.size() <= 9)
+        {
+            refOptions.m_simSeconds = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--sim-joins" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 6 && std::stoul(value) >= 1 && std::stoul(value) <= 100000)
+        {
+            refOptions.m_simJoins = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--load" && (value == "poisson" || value == "bursty"))
+        {
+            refOptions.m_isLoad = true;
+            refOptions.m_loadOptions.m_arrival = (value == "bursty") ? load::ArrivalProcess::ArrivalBursty : load::ArrivalProcess::ArrivalPoisson;
+        }
+        else if (key == "--load-rate" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 7 && std::stoul(value) >= 1 && std::stoul(value) <= 1000000)
+        {
+            refOptions.m_loadOptions.m_rate = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--load-seconds" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 5 && std::stoul(value) >= 1 && std::stoul(value) <= 86400)
+        {
+            refOptions.m_loadOptions.m_seconds = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--load-threads" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 2 && std::stoul(value) >= 1 && std::stoul(value) <= 64)
+        {
+            refOptions.m_loadOptions.m_threads = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--load-players" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 8 && std::stoul(value) >= 1 && std::stoul(value) <= 10000000)
+        {
+            refOptions.m_loadOptions.m_players = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (key == "--metrics-port" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos
+            && value.size() <= 5 && std::stoul(value) >= 1 && std::stoul(value) <= 65535)
+        {
+            refOptions.m_metricsPort = static_cast<uint16_t>(std::stoul(value));
+        }
+        else if (key == "--log-level" && LogManager::parseLevel(value, refOptions.m_logLevel))
+        {
+			// parsed into refOptions.m_logLevel
+        }
+        else
+        {
+            std::cerr << "Unknown option '" << arg << "'.\n";
+            std::cerr << "Usage: " << argv[0] << " [--store=<sqlite|memory>] [--db-shards=<1..64>] [--bench=<shards|rng|matchmaking|micro>] [--threads=<0..256>] [--pin-threads] [--seed=<n>] [--log-level=<debug|info|warning|error>] [--clock=<real|virtual>] [--sim-seconds=<n>] [--sim-joins=<1..100000>] [--load=<poisson|bursty>] [--load-rate=<1..1000000>] [--load-seconds=<1..86400>] [--load-threads=<1..64>] [--load-players=<1..10000000>] [--metrics-port=<1..65535>]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
 // simulate player matchmaking by ID
 void simulatePlayer(uint64_t playerId)
 {
@@ -118,13 +365,16 @@ void simulatePlayer(uint64_t playerId)
         std::cout << " player " << playerId << " is not in lobby.\n";
     }
     //std::cout << "Waiting 1 seconds for players to potentially match...\n";
-	std::this_thread::sleep_for(std::chrono::seconds(1));
+	ClockManager::instance().sleepFor(std::chrono::seconds(1));
 }
 
 // simulate a batch of players
-void simulateBatch(uint32_t counts)
+void simulateBatch(uint32_t counts, bool isVerbose)
 {
-    std::cout << "--- Starting player simulation batch ---\n";
+    if (isVerbose)
+    {
+        std::cout << "--- Starting player simulation batch ---\n";
+    }
 
     std::vector<uint64_t> vecLoggedInIds;
 
@@ -153,9 +403,12 @@ void simulateBatch(uint32_t counts)
                 vecLoggedInIds.emplace_back(playerId);
                 BattleManager::instance().addPlayerToQueue(pPlayer);
 				tmpSetGotIds.emplace(playerId);
-                std::cout << " player " << playerId << " join matchQueue.\n";
+                if (isVerbose)
+                {
+                    std::cout << " player " << playerId << " join matchQueue.\n";
+                }
             }
-            else
+            else if (isVerbose)
             {
                 std::cout << " player " << playerId << " is not in lobby.\n";
             }
@@ -167,11 +420,34 @@ void simulateBatch(uint32_t counts)
     }
 
     //std::cout << "Waiting 1 seconds for players to potentially match...\n";
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    ClockManager::instance().sleepFor(std::chrono::seconds(1));
+}
+
+void runSimulation(uint32_t simSeconds, uint32_t joinsPerSecond)
+{
+    ClockManager& refClock = ClockManager::instance();
+    std::cout << "--- Simulation : " << simSeconds << " s of " << (refClock.isVirtual() ? "virtual" : "real")
+        << " time, " << joinsPerSecond << " players joining per second ---\n";
+
+    const auto realBeginTime = std::chrono::steady_clock::now();
+	refClock.attachThread();    // the arrivals are part of the simulation, the clock waits for each batch
+    const auto simEndTime = refClock.now() + std::chrono::seconds(simSeconds);
+    while (refClock.now() < simEndTime)
+    {
+		simulateBatch(joinsPerSecond, false);   // sleeps one second afterwards
+    }
+    refClock.detachThread();
+
+    const double realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - realBeginTime).count();
+    std::cout << "--- Simulation finished : " << simSeconds << " s simulated in " << std::fixed << std::setprecision(2) << realSeconds << " s ("
+        << ((realSeconds > 0.0) ? simSeconds / realSeconds : 0.0) << "x), " << BattleManager::instance().getStartedBattles() << " battles started, "
+        << BattleManager::instance().getFinishedBattles() << " finished ---\n";
+    std::cout.unsetf(std::ios::fixed);
 }
 
 void commandThread()
 {
+    TraceManager::setThreadName("command");
     std::cout << "\nCommand thread started. \nPlease type 'help' to see available commands.\n";
 
     std::string line_input;
@@ -208,6 +484,13 @@ void commandThread()
             std::cout << "  top <count>    : Display top players sorted list. 'count' is optional (default: 10).\n";
             std::cout << "  list           : Display all players.\n";
             std::cout << "  show <id1>[,<id2>,...] : Display specific player(s) by their ID(s).\n";
+            std::cout << "  saves          : Display player save counters (rows written, writes avoided).\n";
+            std::cout << "  history <id> [count] : Display the latest battles of a player. 'count' is optional (default: 50).\n";
+            std::cout << "  sched          : Display scheduled task statistics (runs, run time, lateness, overruns).\n";
+            std::cout << "  stats [reset]  : Display matchmaking statistics (queue depth, active rooms, rooms/sec, wait times per tier). 'reset' clears the wait times.\n";
+            std::cout << "  log [level]    : Display or set the log level (debug, info, warning, error). Debug lines are compiled out in release builds.\n";
+            std::cout << "  trace start [file] | stop : Record hot-path spans and write them as a Chrome/Perfetto trace (default file: trace.json).\n";
+            std::cout << "  locks [reset]  : Display lock contention (acquisitions, contended, wait and hold times per lock). Needs a LOCK_PROFILING build.\n";
             std::cout << "  exit           : Shut down the game demo.\n";
             std::cout << "--------------------------\n";
         }
@@ -215,6 +498,98 @@ void commandThread()
         {
             listAllPlayers();
         }
+        else if (command_name == "saves")
+        {
+            std::cout << "\n--- Player Saves ---\n";
+            std::cout << "  rows written   : " << PlayerManager::instance().getSavedWrites() << "\n";
+            std::cout << "  writes avoided : " << PlayerManager::instance().getAvoidedWrites() << "\n";
+        }
+        else if (command_name == "sched")
+        {
+            showScheduleStats();
+        }
+        else if (command_name == "stats")
+        {
+            std::string argReset;
+            if (iss >> argReset)
+            {
+                if (argReset != "reset")
+                {
+                    std::cout << "Usage: stats [reset]\n";
+                    continue;
+                }
+                BattleManager::instance().resetWaitStats();
+                std::cout << "Matchmaking wait statistics cleared.\n";
+                continue;
+            }
+            showMatchmakingStats();
+        }
+        else if (command_name == "log")
+        {
+            std::string argLevel;
+            logging::LogLevel level = logging::LogLevel::LogLevelInfo;
+            if (iss >> argLevel)
+            {
+                if (!LogManager::parseLevel(argLevel, level))
+                {
+                    std::cout << "Usage: log [debug|info|warning|error]\n";
+                    continue;
+                }
+                LogManager::instance().setLevel(level);
+            }
+            std::cout << "Log level : " << LogManager::getLevelName(LogManager::instance().getLevel())
+                << " (" << LogManager::instance().getWrittenRecords() << " records written, " << LogManager::instance().getDroppedRecords() << " dropped)\n";
+        }
+        else if (command_name == "locks")
+        {
+            if (!LockProfiler::isCompiledIn())
+            {
+                std::cout << "Lock profiling is not compiled in, build with LOCK_PROFILING defined.\n";
+                continue;
+            }
+            std::string argReset;
+            if (iss >> argReset)
+            {
+                if (argReset != "reset")
+                {
+                    std::cout << "Usage: locks [reset]\n";
+                    continue;
+                }
+                LockProfiler::instance().reset();
+                std::cout << "Lock statistics cleared.\n";
+                continue;
+            }
+            showLockStats();
+        }
+        else if (command_name == "trace")
+        {
+            std::string argAction;
+            iss >> argAction;
+            if (argAction == "start")
+            {
+                std::string argFile = "trace.json";
+                iss >> argFile;
+                if (!TraceManager::instance().start(argFile))
+                {
+                    std::cout << "Trace already recording to " << TraceManager::instance().getFileName() << ".\n";
+                }
+            }
+            else if (argAction == "stop")
+            {
+                if (!TraceManager::isEnabled())
+                {
+                    std::cout << "Trace is not recording.\n";
+                }
+                else if (!TraceManager::instance().stop())
+                {
+                    std::cout << "Failed to write " << TraceManager::instance().getFileName() << ".\n";
+                }
+            }
+            else
+            {
+                std::cout << "Usage: trace start [file] | trace stop\n";
+            }
+        }
         else if (command_name == "queue")
         {
             auto pTeamTierQueues = BattleManager::instance().getTeamMatchQueue();
@@ -379,13 +754,13 @@ void commandThread()
 
             std::stringstream id_stream(arg_string);
             std::string single_id_str;
+            std::vector<uint64_t> vecJoinIds;
 
             while (id_stream >> single_id_str)
             {
                 try 
                 {
-                    uint64_t playerId = std::stoull(single_id_str);
-                    simulatePlayer(playerId);
+                    vecJoinIds.emplace_back(std::stoull(single_id_str));
                 }
                 catch (const std::invalid_argument&)
                 {
@@ -395,6 +770,12 @@ void commandThread()
                 {
                     std::cout << "Player ID '" << single_id_str << "' is out of range.\n";
                 }
+            }
+
+			PlayerManager::instance().preloadPlayers(vecJoinIds);  // one store query for all players not in memory
+            for (uint64_t playerId : vecJoinIds)
+            {
+                simulatePlayer(playerId);
             }
         }
         else if (command_name == "batch")
@@ -458,6 +839,39 @@ void commandThread()
             }
             showTopPlayers(count);
         }
+        else if (command_name == "history")
+        {
+            std::string argId;
+            if (!(iss >> argId))
+            {
+                std::cout << "Usage: history <id> [count]\n";
+                continue;
+            }
+            try
+            {
+                const uint64_t playerId = std::stoull(argId);
+                int count = 50; // default
+                std::string argCount;
+                if (iss >> argCount)
+                {
+                    count = std::stoi(argCount);
+                    if (count <= 0)
+                    {
+                        std::cout << "Count must be a positive number.\n";
+                        continue;
+                    }
+                }
+                showPlayerHistory(playerId, static_cast<uint32_t>(count));
+            }
+            catch (const std::invalid_argument&)
+            {
+                std::cout << "Invalid argument format. Usage: history <id> [count]\n";
+            }
+            catch (const std::out_of_range&)
+            {
+                std::cout << "Argument is out of range. Usage: history <id> [count]\n";
+            }
+        }
         else if (command_name == "exit")
         {
             exitGame();
@@ -590,27 +1004,7 @@ void showTopPlayers(size_t counts)
 		counts = maxSize;
     }
 
-    std::vector<Player*> tmpVecPlayers;
-    for (const auto& pair : *pMapPlayers)
-    {
-        tmpVecPlayers.push_back(pair.second.get());
-    }
-
-	// sorting rules:
-	// 1. score (descending)
-	// 2. wins (descending)
-	// 3. id (ascending)
-    std::sort(tmpVecPlayers.begin(), tmpVecPlayers.end(), [](const Player* a, const Player* b) {
-        if (a->getScore() != b->getScore())
-        {
-            return a->getScore() > b->getScore();
-        }
-        if (a->getWins() != b->getWins())
-        {
-            return a->getWins() > b->getWins();
-        }
-        return a->getId() < b->getId();
-        });
+    const std::vector<Player*> tmpVecPlayers = PlayerManager::instance().getTopPlayers(counts);
 
     std::cout << "\n----- TOP " << counts << " PLAYERS -----\n";
     std::cout << std::left << std::setw(5) << "Rank"
@@ -642,6 +1036,191 @@ void showTopPlayers(size_t counts)
     std::cout << "---------------------------------------------------\n";
 }
 
+void showPlayerHistory(uint64_t playerId, uint32_t counts)
+{
+    std::vector<PlayerBattleHistory> vecHistory;
+    if (!HistoryManager::instance().queryPlayerHistory(playerId, counts, vecHistory))
+    {
+        std::cout << "Battle history is not available.\n";
+        return;
+    }
+    if (vecHistory.empty())
+    {
+        std::cout << "No battles for player " << playerId << ".\n";
+        return;
+    }
+
+    std::cout << "\n----- BATTLE HISTORY (Player " << playerId << ") -----\n";
+    std::cout << std::left << std::setw(10) << "Battle"
+        << std::setw(25) << "Time"
+        << std::setw(6) << "Tier"
+        << std::setw(8) << "Result"
+        << std::setw(8) << "Score"
+        << std::setw(20) << "Red"
+        << "Blue" << "\n";
+    std::cout << "---------------------------------------------------\n";
+    for (const auto& history : vecHistory)
+    {
+        std::cout << std::left << std::setw(10) << history.m_battleId
+            << std::setw(25) << time_utils::formatTimestampMs(history.m_battleTime)
+            << std::setw(6) << history.m_tier
+            << std::setw(8) << ((history.m_team == history.m_winner) ? "Win" : "Lose")
+            << std::setw(8) << ((history.m_scoreDelta >= 0) ? "+" : "") + std::to_string(history.m_scoreDelta)
+            << std::setw(20) << history.m_redTeam
+            << history.m_blueTeam << "\n";
+    }
+    std::cout << "---------------------------------------------------\n";
+}
+
+void showScheduleStats()
+{
+    std::vector<ScheduledTaskStats> vecStats;
+    ScheduleManager::instance().getTaskStats(vecStats);
+
+	// microseconds as milliseconds with 2 decimals
+    auto formatMs = [](uint64_t valueUs)
+        {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(2) << (valueUs / 1000.0);
+            return oss.str();
+        };
+
+    std::cout << "\n----- SCHEDULED TASKS (times in ms) -----\n";
+    std::cout << std::left << std::setw(16) << "Task"
+        << std::setw(12) << "Interval"
+        << std::setw(8) << "Runs"
+        << std::setw(10) << "Overruns"
+        << std::setw(9) << "Skipped"
+        << std::setw(10) << "Run p50"
+        << std::setw(10) << "Run p99"
+        << std::setw(10) << "Run max"
+        << std::setw(10) << "Late avg"
+        << std::setw(10) << "Late p99"
+        << std::setw(10) << "Late max"
+        << "State" << "\n";
+    std::cout << "---------------------------------------------------\n";
+    for (const auto& stats : vecStats)
+    {
+        std::cout << std::left << std::setw(16) << stats.m_name
+            << std::setw(12) << formatMs(std::chrono::duration_cast<std::chrono::microseconds>(stats.m_interval).count())
+            << std::setw(8) << stats.m_runs
+            << std::setw(10) << stats.m_overruns
+            << std::setw(9) << stats.m_skippedPeriods
+            << std::setw(10) << formatMs(stats.m_runTimeP50Us)
+            << std::setw(10) << formatMs(stats.m_runTimeP99Us)
+            << std::setw(10) << formatMs(stats.m_runTimeMaxUs)
+            << std::setw(10) << formatMs(stats.m_latenessMeanUs)
+            << std::setw(10) << formatMs(stats.m_latenessP99Us)
+            << std::setw(10) << formatMs(stats.m_latenessMaxUs)
+            << (stats.m_isRunning ? "running" : "waiting") << (stats.m_isLongRunning ? " (long)" : "") << "\n";
+    }
+    std::cout << "---------------------------------------------------\n";
+}
+
+void showMatchmakingStats()
+{
+    BattleManager& refBattle = BattleManager::instance();
+
+	// microseconds as milliseconds with 2 decimals
+    auto formatMs = [](uint64_t valueUs)
+        {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(2) << (valueUs / 1000.0);
+            return oss.str();
+        };
+
+    std::cout << "\n----- MATCHMAKING (wait times in ms) -----\n";
+    std::cout << std::left << std::setw(6) << "Tier"
+        << std::setw(9) << "Queued"
+        << std::setw(7) << "Teams"
+        << std::setw(11) << "Team p50"
+        << std::setw(11) << "Team p99"
+        << std::setw(11) << "Team max"
+        << std::setw(11) << "Battle p50"
+        << std::setw(11) << "Battle p99"
+        << "Battle max" << "\n";
+    std::cout << "---------------------------------------------------\n";
+    for (uint32_t tier = battle::Tier::TierMin; tier <= battle::Tier::TierMax; tier++)
+    {
+        const TierQueueStats& refStats = refBattle.getTierStats(tier);
+        const int64_t queuedPlayers = refStats.m_queuedPlayers.load(std::memory_order_relaxed);
+        if (queuedPlayers == 0 && refStats.m_teamWaitHistogram.getCount() == 0)
+        {
+            continue;
+        }
+        std::cout << std::left << std::setw(6) << tier
+            << std::setw(9) << queuedPlayers
+            << std::setw(7) << refStats.m_queuedTeams.load(std::memory_order_relaxed)
+            << std::setw(11) << formatMs(refStats.m_teamWaitHistogram.getPercentile(50.0))
+            << std::setw(11) << formatMs(refStats.m_teamWaitHistogram.getPercentile(99.0))
+            << std::setw(11) << formatMs(refStats.m_teamWaitHistogram.getMax())
+            << std::setw(11) << formatMs(refStats.m_battleWaitHistogram.getPercentile(50.0))
+            << std::setw(11) << formatMs(refStats.m_battleWaitHistogram.getPercentile(99.0))
+            << formatMs(refStats.m_battleWaitHistogram.getMax()) << "\n";
+    }
+    std::cout << "---------------------------------------------------\n";
+
+    const LatencyHistogram& refWait = refBattle.getQueueWaitHistogram();
+    std::cout << "  queued players : " << refBattle.getQueuedPlayers() << "\n";
+    std::cout << "  active rooms   : " << refBattle.getActiveRooms() << "\n";
+    std::cout << "  rooms/sec      : " << std::fixed << std::setprecision(1) << refBattle.getRoomsPerSec() << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << "  battles        : " << refBattle.getStartedBattles() << " started, " << refBattle.getFinishedBattles() << " finished\n";
+    std::cout << "  queue wait     : p50 " << formatMs(refWait.getPercentile(50.0)) << ", p99 " << formatMs(refWait.getPercentile(99.0))
+        << ", max " << formatMs(refWait.getMax()) << " (" << refWait.getCount() << " players)\n";
+}
+
+void showLockStats()
+{
+    std::vector<const LockStats*> vecStats;
+    LockProfiler::instance().getAllStats(vecStats);
+	// the lock costing the most waiting first
+    std::sort(vecStats.begin(), vecStats.end(), [](const LockStats* pLhs, const LockStats* pRhs)
+        {
+            return pLhs->m_waitHistogram.getSum() > pRhs->m_waitHistogram.getSum();
+        });
+
+	// nanoseconds as microseconds with 2 decimals
+    auto formatUs = [](uint64_t valueNs)
+        {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(2) << (valueNs / 1000.0);
+            return oss.str();
+        };
+
+    std::cout << "\n----- LOCKS (wait and hold times in us) -----\n";
+    std::cout << std::left << std::setw(42) << "Lock"
+        << std::setw(12) << "Acquired"
+        << std::setw(12) << "Contended"
+        << std::setw(10) << "Wait p50"
+        << std::setw(10) << "Wait p99"
+        << std::setw(12) << "Wait max"
+        << std::setw(12) << "Wait total"
+        << std::setw(10) << "Hold p50"
+        << std::setw(10) << "Hold p99"
+        << "Hold max" << "\n";
+    std::cout << "---------------------------------------------------\n";
+    for (const LockStats* pStats : vecStats)
+    {
+        const uint64_t acquisitions = pStats->m_acquisitions.load(std::memory_order_relaxed);
+        const uint64_t contendedAcquisitions = pStats->m_contendedAcquisitions.load(std::memory_order_relaxed);
+        std::ostringstream ossContended;
+        ossContended << contendedAcquisitions << " (" << std::fixed << std::setprecision(1)
+            << (acquisitions > 0 ? contendedAcquisitions * 100.0 / acquisitions : 0.0) << "%)";
+        std::cout << std::left << std::setw(42) << pStats->m_name
+            << std::setw(12) << acquisitions
+            << std::setw(12) << ossContended.str()
+            << std::setw(10) << formatUs(pStats->m_waitHistogram.getPercentile(50.0))
+            << std::setw(10) << formatUs(pStats->m_waitHistogram.getPercentile(99.0))
+            << std::setw(12) << formatUs(pStats->m_waitHistogram.getMax())
+            << std::setw(12) << formatUs(pStats->m_waitHistogram.getSum())
+            << std::setw(10) << formatUs(pStats->m_holdHistogram.getPercentile(50.0))
+            << std::setw(10) << formatUs(pStats->m_holdHistogram.getPercentile(99.0))
+            << formatUs(pStats->m_holdHistogram.getMax()) << "\n";
+    }
+    std::cout << "---------------------------------------------------\n";
+}
+
 // exit game and clean up resources
 void exitGame()
 {
@@ -649,10 +1228,23 @@ void exitGame()
     std::cout << "Exiting game...\n";
 
 	// release managers
+	MetricsManager::instance().release();  // no scrape during the shutdown
+	// no new battle, then let the running battle jobs finish before the rooms are freed
+    BattleManager::instance().stopMatchmaking();
+    BattleManager::instance().stopBattleTimer();
+    ExecutorManager::instance().waitIdle();
     BattleManager::instance().release();
-    PlayerManager::instance().release();
-	ScheduleManager::instance().release();
-    DbManager::instance().release();
+	HistoryManager::instance().release();  // write the remaining battles before the store is closed
+	ScheduleManager::instance().release();  // no periodic save or snapshot runs beside the final ones
+	PlayerManager::instance().saveDirtyPlayers();   // flush the dirty players, then checkpoint the journal
+	SnapshotManager::instance().writeSnapshot();    // write the final snapshot before player data is released
+	SnapshotManager::instance().release();
+	JournalManager::instance().release();
+	PlayerManager::instance().release();    // close the player store as well
+	TraceManager::instance().release();     // write a trace still recording, shutdown spans included
+	ExecutorManager::instance().release();  // the managers above submit to it
+	ClockManager::instance().release();
+	LogManager::instance().release();       // last, writes the remaining log lines
 
 	// --- add any other necessary cleanup code here ---
 
@@ -4,6 +4,13 @@
 // @date  : 2025-05-15
 #include "battleManager.h"
 #include "playerManager.h"
+#include "historyManager.h"
+#include "journalManager.h"
+#include "scheduleManager.h"
+#include "executorManager.h"
+#include "logManager.h"
+#include "clockManager.h"
+#include "traceManager.h"
 #include "../../include/globalDefine.h"
 #include "../../utils/utils.h"
 #include <iostream>
@@ -12,14 +19,42 @@
 #include <thread>
 #include <chrono>
 
+const std::chrono::seconds BATTLE_DURATION(3);   // simulated battle time
+const std::chrono::seconds ROOMS_RATE_WINDOW(1); // window of the rooms/sec gauge
+const std::chrono::milliseconds BATTLE_TIMER_INTERVAL(100);    // a battle ends at most this late
+
+#if !defined(NDEBUG) || defined(LOG_DEBUG_IN_RELEASE)
+// one line with the player and hero ids of a full team, only where LOG_DEBUG is compiled in
+static void logTeamMembers(const char* teamName, const std::vector<std::unique_ptr<Hero>>& refVecTeam)
+{
+    if (refVecTeam.size() == battle::TeamMembers::TeamMemberMax)
+    {
+        LOG_DEBUG("{} team members: {}(hero:{}) {}(hero:{}) {}(hero:{})", teamName,
+            refVecTeam[battle::TeamMembers::TeamLeader]->getPlayerId(), refVecTeam[battle::TeamMembers::TeamLeader]->getId(),
+            refVecTeam[battle::TeamMembers::TeamMember1]->getPlayerId(), refVecTeam[battle::TeamMembers::TeamMember1]->getId(),
+            refVecTeam[battle::TeamMembers::TeamMember2]->getPlayerId(), refVecTeam[battle::TeamMembers::TeamMember2]->getId());
+    }
+}
+#endif
+
 BattleRoom::BattleRoom(const std::vector<Player*>& refVecTeamRed, const std::vector<Player*>& refVecTeamBlue)
     : m_roomId(BattleManager::instance().getNextRoomId())
 {
+    TRACE_SPAN("BattleRoom::BattleRoom");
+	// teams are matched within one tier
+    if (!refVecTeamRed.empty() && refVecTeamRed[0])
+    {
+        m_tier = refVecTeamRed[0]->getTier();
+    }
+
+    const auto now = ClockManager::instance().now();
+
 	// red team
     for (Player* pPlayer : refVecTeamRed)
     {
         if (pPlayer)
         {
+            BattleManager::instance().recordQueueWait(std::chrono::duration_cast<std::chrono::microseconds>(now - pPlayer->getQueueEnterTime()).count());
             pPlayer->setStatus(common::PlayerStatus::battle);
             m_vecTeamRed.emplace_back(std::make_unique<Hero>(pPlayer->getId()));
         }
@@ -30,45 +65,30 @@ BattleRoom::BattleRoom(const std::vector<Player*>& refVecTeamRed, const std::vec
     {
         if (pPlayer)
         {
+            BattleManager::instance().recordQueueWait(std::chrono::duration_cast<std::chrono::microseconds>(now - pPlayer->getQueueEnterTime()).count());
             pPlayer->setStatus(common::PlayerStatus::battle);
             m_vecTeamBlue.emplace_back(std::make_unique<Hero>(pPlayer->getId()));
         }
     }
-    std::cout << "Battle Room " << m_roomId << " created." << std::endl;
+    LOG_DEBUG("Battle Room {} created.", m_roomId);
 }
 
 BattleRoom::~BattleRoom()
 {
-    std::cout << "Battle Room " << m_roomId << " destroyed." << std::endl;
+    LOG_DEBUG("Battle Room {} destroyed.", m_roomId);
 }
 
 void BattleRoom::startBattle()
 {
-    std::cout << "red team members: ";
-    for (const auto& pHero : m_vecTeamRed)
-    {
-        if (pHero)
-        {
-            std::cout << pHero->getPlayerId() << "(hero:" << pHero->getId() << ") ";
-        }
-    }
-    std::cout << std::endl;
-
-    std::cout << "blue team members: ";
-    for (const auto& pHero : m_vecTeamBlue)
-    {
-        if (pHero)
-        {
-            std::cout << pHero->getPlayerId() << "(hero:" << pHero->getId() << ") ";
-        }
-    }
-    std::cout << std::endl;
-
-    std::cout << "\n----- BATTLE START (Room " << m_roomId << ") -----" << std::endl;
-
-	// simulate battle for 3 seconds
-    std::this_thread::sleep_for(std::chrono::seconds(3));
+#if !defined(NDEBUG) || defined(LOG_DEBUG_IN_RELEASE)
+    logTeamMembers("red", m_vecTeamRed);
+    logTeamMembers("blue", m_vecTeamBlue);
+#endif
+    LOG_DEBUG("\n----- BATTLE START (Room {}) -----", m_roomId);
+}
 
+void BattleRoom::endBattle()
+{
 	// simulate battle result(50% chance for each team to win)
     uint8_t dice = 2;
     bool isRedWin = (random_utils::getRandom(dice) == 0);
@@ -76,35 +96,70 @@ void BattleRoom::startBattle()
     std::vector<std::unique_ptr<Hero>>& vecWinningTeam = isRedWin ? m_vecTeamRed : m_vecTeamBlue;
     std::vector<std::unique_ptr<Hero>>& vecLosingTeam = isRedWin ? m_vecTeamBlue : m_vecTeamRed;
 
-    std::cout << "\n" << (isRedWin ? "Red" : "Blue") << " Team wins in Room " << m_roomId << "!!!" << std::endl;
+    LOG_DEBUG("\n{} Team wins in Room {}!!!", isRedWin ? "Red" : "Blue", m_roomId);
+
+    BattleHistoryRecord historyRecord;
+    historyRecord.m_roomId = m_roomId;
+    historyRecord.m_tier = m_tier;
+    historyRecord.m_winner = isRedWin ? battle::TeamColor::TeamColorRed : battle::TeamColor::TeamColorBlue;
+    historyRecord.m_vecMembers.reserve(m_vecTeamRed.size() + m_vecTeamBlue.size());
+    const uint8_t loserTeam = isRedWin ? battle::TeamColor::TeamColorBlue : battle::TeamColor::TeamColorRed;
 
     for (auto& pHero : vecWinningTeam)
     {
         if (!pHero) continue;
         const uint64_t playerId = pHero->getPlayerId();
-        BattleManager::instance().handlePlayerWin(playerId);
+        const uint32_t winnerScore = BattleManager::instance().handlePlayerWin(playerId);
+        historyRecord.m_vecMembers.emplace_back(BattleHistoryMember{ playerId, historyRecord.m_winner, static_cast<int32_t>(winnerScore) });
     }
 
     for (auto& pHero : vecLosingTeam)
     {
         if (!pHero) continue;
         const uint64_t playerId = pHero->getPlayerId();
-        BattleManager::instance().handlePlayerLose(playerId);
+        const uint32_t loserScore = BattleManager::instance().handlePlayerLose(playerId);
+        historyRecord.m_vecMembers.emplace_back(BattleHistoryMember{ playerId, loserTeam, -static_cast<int32_t>(loserScore) });
     }
-    std::cout << "----- BATTLE STOP (Room " << m_roomId << ") -----\n" << std::endl;
+    historyRecord.m_battleTime = ClockManager::instance().getTimestampMS();
+    std::vector<uint64_t> vecPlayerIds;
+    if (BattleManager::instance().isAutoRequeue())
+    {
+        for (const auto& member : historyRecord.m_vecMembers)
+        {
+            vecPlayerIds.emplace_back(member.m_playerId);
+        }
+    }
+    HistoryManager::instance().addBattle(std::move(historyRecord));
+    LOG_DEBUG("----- BATTLE STOP (Room {}) -----\n", m_roomId);
 
     finishBattle();
+
+	// the results of all players are at or before the last sequence, one wait per battle without blocking the worker
+	// the players are requeued once their results are synced, the room is gone by then
+    const uint64_t roomId = m_roomId;
+    JournalManager::instance().callWhenDurable(JournalManager::instance().getLastSeq(), [roomId, vecPlayerIds](bool isDurable)
+    {
+        if (!isDurable)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Battle results of Room " << roomId << " are not journaled, kept in memory until the next flush."
+                << std::endl;
+        }
+        if (!vecPlayerIds.empty())
+        {
+            BattleManager::instance().requeuePlayers(vecPlayerIds);
+        }
+    });
 }
 
 void BattleRoom::finishBattle()
 {
-    const uint64_t orgRoomId = m_roomId;
-    std::cout << "Battle finished for Room " << orgRoomId << "." << std::endl;
+    LOG_DEBUG("Battle finished for Room {}.", m_roomId);
     m_vecTeamRed.clear();
     m_vecTeamBlue.clear();
-
-    BattleManager::instance().removeBattleRoom(orgRoomId);
-    std::cout << "----- BATTLE FINISHED (Room " << orgRoomId << ") -----\n" << std::endl;
+    LOG_DEBUG("----- BATTLE FINISHED (Room {}) -----\n", m_roomId);
 }
 
 TeamMatchQueue::TeamMatchQueue() {}
@@ -112,22 +167,23 @@ TeamMatchQueue::~TeamMatchQueue() {}
 
 void TeamMatchQueue::addMember(Player* pPlayer)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
     uint32_t tier = pPlayer->getTier();
     m_mapTierQueues[tier].emplace_back(pPlayer);
-    std::cout << "Player " << pPlayer->getId() << " added to TEAM match queue for tier " << tier << std::endl;
+    LOG_DEBUG("Player {} added to TEAM match queue for tier {}", pPlayer->getId(), tier);
 }
 
 bool TeamMatchQueue::hasEnoughMemberForTeam(uint32_t tier)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
     auto it = m_mapTierQueues.find(tier);
     return (it != m_mapTierQueues.end()) && (it->second.size() >= battle::TeamMembers::TeamMemberMax);
 }
 
 std::vector<Player*> TeamMatchQueue::getPlayersForTeam(uint32_t tier)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+	TRACE_SPAN("TeamMatchQueue::getPlayersForTeam");   // lock wait included
+    std::lock_guard<ProfiledMutex> lock(mutex);
     std::vector<Player*> teamPlayers;
     auto it = m_mapTierQueues.find(tier);
 
@@ -147,13 +203,13 @@ std::vector<Player*> TeamMatchQueue::getPlayersForTeam(uint32_t tier)
 
 const std::map<uint32_t, std::vector<Player*>> TeamMatchQueue::getTierQueue() const
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
 	return m_mapTierQueues;
 }
 
 void TeamMatchQueue::clear()
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
     _clearNoLock();
 }
 
@@ -168,29 +224,29 @@ BattleMatchQueue::~BattleMatchQueue() {}
 
 void BattleMatchQueue::addTeam(std::vector<Player*> team)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
     if (team.empty()) { return; }
     uint32_t tier = team[0]->getTier();
     m_mapTierQueues[tier].emplace_back(team);
 
-    std::cout << "Team (Tier " << tier << ") added to BATTLE match queue. Players: ";
-    for (Player* p : team)
+    if (team.size() == battle::TeamMembers::TeamMemberMax)
     {
-        std::cout << p->getId() << " ";
+        LOG_DEBUG("Team (Tier {}) added to BATTLE match queue. Players: {} {} {}", tier, team[battle::TeamMembers::TeamLeader]->getId(),
+            team[battle::TeamMembers::TeamMember1]->getId(), team[battle::TeamMembers::TeamMember2]->getId());
     }
-    std::cout << std::endl;
 }
 
 bool BattleMatchQueue::hasEnoughTeamsForBattle(uint32_t tier)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
     auto it = m_mapTierQueues.find(tier);
     return (it != m_mapTierQueues.end()) && (it->second.size() >= battle::TeamColor::TeamColorMax);
 }
 
 std::vector<std::vector<Player*>> BattleMatchQueue::getTeamsForBattle(uint32_t tier)
 {
-    std::lock_guard<std::mutex> lock(mutex);
+	TRACE_SPAN("BattleMatchQueue::getTeamsForBattle"); // lock wait included
+    std::lock_guard<ProfiledMutex> lock(mutex);
     std::vector<std::vector<Player*>> battleTeams;
     auto it = m_mapTierQueues.find(tier);
 
@@ -208,13 +264,13 @@ std::vector<std::vector<Player*>> BattleMatchQueue::getTeamsForBattle(uint32_t t
 
 const std::map<uint32_t, std::vector<std::vector<Player*>>> BattleMatchQueue::getTierQueue() const
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
 	return m_mapTierQueues;
 }
 
 void BattleMatchQueue::clear()
 {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard<ProfiledMutex> lock(mutex);
     _clearNoLock();
 }
 
@@ -248,18 +304,23 @@ bool BattleManager::initialize()
 void BattleManager::release()
 {
     stopMatchmaking();
+    stopBattleTimer();
 
 	// lock all mutexes in automatic mode to avoid deadlock
-    std::unique_lock<std::mutex> lockBattleRooms(m_battleRoomsMutex, std::defer_lock);
-    std::unique_lock<std::mutex> lockTeamQueue(m_teamMatchQueue.mutex, std::defer_lock);
-    std::unique_lock<std::mutex> lockBattleQueue(m_battleMatchQueue.mutex, std::defer_lock);
+    std::unique_lock<ProfiledMutex> lockBattleRooms(m_battleRoomsMutex, std::defer_lock);
+    std::unique_lock<ProfiledMutex> lockTeamQueue(m_teamMatchQueue.mutex, std::defer_lock);
+    std::unique_lock<ProfiledMutex> lockBattleQueue(m_battleMatchQueue.mutex, std::defer_lock);
 
 	std::lock(lockBattleRooms, lockTeamQueue, lockBattleQueue); // lock all at once
 
 	// clear all resources
     m_battleRooms.clear();
+    m_queBattleEnds = {};
     m_teamMatchQueue._clearNoLock();
     m_battleMatchQueue._clearNoLock();
+    _resetQueueGauges();
+    m_activeRooms.store(0);
+    m_roomsPerSec.store(0.0);
 
     m_nextRoomId.store(0);
     std::cout << "[BattleManager] : released! " << std::endl;
@@ -273,6 +334,18 @@ void BattleManager::startMatchmaking()
 		// create a new thread for matchmaking
         m_matchmakingThreadHandle = std::thread(&BattleManager::matchmakingThread, this);
     }
+    if (!m_battleTimer.isActive())
+    {
+		// battles go on after the matchmaking stops (benchmark rounds)
+        ScheduleOptions options;
+        options.m_name = "battle_rooms";
+        m_battleTimer = ScheduleManager::instance().registerTask([this]() { this->_endDueBattles(); }, BATTLE_TIMER_INTERVAL, options);
+    }
+}
+
+void BattleManager::stopBattleTimer()
+{
+    m_battleTimer.cancel();
 }
 
 void BattleManager::stopMatchmaking()
@@ -294,30 +367,124 @@ void BattleManager::addPlayerToQueue(Player* pPlayer)
     {
         return;
     }
-    std::lock_guard<std::mutex> lock(m_playerAddQueueMutex);
+    std::lock_guard<ProfiledMutex> lock(m_playerAddQueueMutex);
     {
         if (pPlayer->isInLobby() == false)
         {
             //std::cerr << "Error: Player " << pPlayer->getId() << " is not in lobby." << std::endl;
             return;
         }
+        pPlayer->setQueueEnterTime(ClockManager::instance().now());
+        _getTierStats(pPlayer->getTier()).m_queuedPlayers.fetch_add(1, std::memory_order_relaxed);
+        m_enqueuedPlayers.add();
         m_teamMatchQueue.addMember(pPlayer);
         pPlayer->setStatus(common::PlayerStatus::queue);
     }
 }
 
-void BattleManager::handlePlayerWin(uint64_t playerId)
+void BattleManager::requeuePlayers(const std::vector<uint64_t>& refVecPlayerIds)
+{
+    for (uint64_t playerId : refVecPlayerIds)
+    {
+        addPlayerToQueue(PlayerManager::instance().getPlayer(playerId));
+    }
+}
+
+size_t BattleManager::getQueuedPlayers() const
+{
+    int64_t queuedPlayers = 0;
+    for (const auto& tierStats : m_arrTierStats)
+    {
+        queuedPlayers += tierStats.m_queuedPlayers.load(std::memory_order_relaxed);
+    }
+    return (queuedPlayers > 0) ? static_cast<size_t>(queuedPlayers) : 0;
+}
+
+void BattleManager::resetWaitStats()
+{
+    m_queueWaitHistogram.reset();
+    for (auto& tierStats : m_arrTierStats)
+    {
+        tierStats.m_teamWaitHistogram.reset();
+        tierStats.m_battleWaitHistogram.reset();
+    }
+}
+
+void BattleManager::recordQueueWait(uint64_t waitUs)
+{
+    m_queueWaitHistogram.record(waitUs);
+    if (m_isQueueWaitSampling.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(m_queueWaitSamplesMutex);
+        m_vecQueueWaitSamples.emplace_back(waitUs);
+    }
+}
+
+void BattleManager::setQueueWaitSampling(bool isEnabled)
+{
+    std::lock_guard<std::mutex> lock(m_queueWaitSamplesMutex);
+    m_vecQueueWaitSamples.clear();
+    m_isQueueWaitSampling = isEnabled;
+}
+
+void BattleManager::takeQueueWaitSamples(std::vector<uint64_t>& refVecSamples)
+{
+    std::lock_guard<std::mutex> lock(m_queueWaitSamplesMutex);
+    refVecSamples.swap(m_vecQueueWaitSamples);
+    m_vecQueueWaitSamples.clear();
+}
+
+void BattleManager::_resetQueueGauges()
+{
+    for (auto& tierStats : m_arrTierStats)
+    {
+        tierStats.m_queuedPlayers.store(0, std::memory_order_relaxed);
+        tierStats.m_queuedTeams.store(0, std::memory_order_relaxed);
+    }
+}
+
+void BattleManager::clearQueues()
+{
+    std::unique_lock<ProfiledMutex> lockTeamQueue(m_teamMatchQueue.mutex, std::defer_lock);
+    std::unique_lock<ProfiledMutex> lockBattleQueue(m_battleMatchQueue.mutex, std::defer_lock);
+    std::lock(lockTeamQueue, lockBattleQueue);
+
+    for (const auto& queuePair : m_teamMatchQueue.m_mapTierQueues)
+    {
+        for (Player* pPlayer : queuePair.second)
+        {
+            pPlayer->setStatus(common::PlayerStatus::lobby);
+        }
+    }
+    for (const auto& queuePair : m_battleMatchQueue.m_mapTierQueues)
+    {
+        for (const auto& vecTeam : queuePair.second)
+        {
+            for (Player* pPlayer : vecTeam)
+            {
+                pPlayer->setStatus(common::PlayerStatus::lobby);
+            }
+        }
+    }
+    m_teamMatchQueue._clearNoLock();
+    m_battleMatchQueue._clearNoLock();
+    _resetQueueGauges();
+}
+
+uint32_t BattleManager::handlePlayerWin(uint64_t playerId)
 {
 	const uint32_t winnerScore = battle::WINNER_ADD_SCORE_BASE + random_utils::getRandom(battle::WINNER_ADD_SCORE_BASE);
-    std::cout << "Player " << playerId << " WIN!!! (+ " << winnerScore << " points)" << std::endl;
+    LOG_DEBUG("Player {} WIN!!! (+ {} points)", playerId, winnerScore);
     PlayerManager::instance().handlePlayerBattleResult(playerId, winnerScore, true);
+    return winnerScore;
 }
 
-void BattleManager::handlePlayerLose(uint64_t playerId)
+uint32_t BattleManager::handlePlayerLose(uint64_t playerId)
 {
 	const uint32_t loserScore = battle::LOSER_SUB_SCORE_BASE + random_utils::getRandom(battle::LOSER_SUB_SCORE_BASE/2);
-    std::cout << "Player " << playerId << " LOSE... (- " << loserScore << " points)" << std::endl;
+    LOG_DEBUG("Player {} LOSE... (- {} points)", playerId, loserScore);
     PlayerManager::instance().handlePlayerBattleResult(playerId, loserScore, false);
+    return loserScore;
 }
 
 // get next room id in atomic way
@@ -326,27 +493,101 @@ uint64_t BattleManager::getNextRoomId()
 	return m_nextRoomId.fetch_add(1);   // automatically increment and return the current value
 }
 
-void BattleManager::removeBattleRoom(uint64_t roomId)
+void BattleManager::runBattle(uint64_t roomId)
 {
-    std::lock_guard<std::mutex> lock(m_battleRoomsMutex);
+	// the room is only used under the lock, release may clear the map meanwhile
+    std::unique_lock<ProfiledMutex> lock(m_battleRoomsMutex);
     auto it = m_battleRooms.find(roomId);
     if (it != m_battleRooms.end())
     {
-        m_battleRooms.erase(it);
-        std::cout << "Removed Battle Room " << roomId << "." << std::endl;
+        it->second->startBattle();
+		// simulate battle for 3 seconds, the battle timer ends it
+        m_queBattleEnds.emplace(ClockManager::instance().now() + BATTLE_DURATION, roomId);
+    }
+    else
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "BattleRoom not found for roomId : " << roomId
+            << std::endl;
+    }
+}
+
+void BattleManager::endBattle(uint64_t roomId)
+{
+	// take the room out of the map, nothing else can free it while it ends
+    std::unique_ptr<BattleRoom> uRoom;
+    {
+        std::lock_guard<ProfiledMutex> lock(m_battleRoomsMutex);
+        auto it = m_battleRooms.find(roomId);
+        if (it != m_battleRooms.end())
+        {
+            uRoom = std::move(it->second);
+            m_battleRooms.erase(it);
+            m_activeRooms.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    if (uRoom)
+    {
+        uRoom->endBattle();
+        m_finishedBattles.fetch_add(1, std::memory_order_relaxed);
+        LOG_DEBUG("Removed Battle Room {}.", roomId);
+    }
+    else if (m_isRunning)
+    {
+		// rooms are cleared on release, timers of those battles find nothing
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "BattleRoom not found for roomId : " << roomId
+            << std::endl;
+    }
+}
+
+void BattleManager::_endDueBattles()
+{
+    std::vector<uint64_t> vecRoomIds;
+    {
+        std::lock_guard<ProfiledMutex> lock(m_battleRoomsMutex);
+        const auto now = ClockManager::instance().now();
+        while (!m_queBattleEnds.empty() && m_queBattleEnds.top().first <= now)
+        {
+            vecRoomIds.emplace_back(m_queBattleEnds.top().second);
+            m_queBattleEnds.pop();
+        }
+    }
+	// one executor job per battle, the rooms end in parallel
+    for (uint64_t roomId : vecRoomIds)
+    {
+        if (!ExecutorManager::instance().submit([roomId]() { BattleManager::instance().endBattle(roomId); }))
+        {
+            endBattle(roomId);
+        }
     }
 }
 
 void BattleManager::matchmakingThread()
 {
     std::cout << "[BattleManager] : Matchmaking thread started" << std::endl;
+	ClockManager::instance().attachThread();    // virtual time waits for each matchmaking pass
+    TraceManager::setThreadName("matchmaking");
+
+	// window of the rooms/sec gauge
+    auto rateWindowBegin = ClockManager::instance().now();
+    uint64_t rateWindowRooms = getStartedBattles();
 
     while (m_isRunning)
     {
+		// the pass without the sleep
+        TraceSpan passSpan("matchmaking.pass");
+
 		// player to team
+        TraceSpan formTeamsSpan("matchmaking.formTeams");
         std::vector<uint32_t> tiersToFormTeams;
         {
-            std::lock_guard<std::mutex> lock(m_teamMatchQueue.mutex);
+            TRACE_SPAN("matchmaking.lockTeamQueue");
+            std::lock_guard<ProfiledMutex> lock(m_teamMatchQueue.mutex);
             for (const auto& queuePair : m_teamMatchQueue.m_mapTierQueues)
             {
                 tiersToFormTeams.emplace_back(queuePair.first);
@@ -361,6 +602,14 @@ void BattleManager::matchmakingThread()
 
                 if (vecNewTeam.size() == battle::TeamMembers::TeamMemberMax)
                 {
+                    TierQueueStats& refTierStats = _getTierStats(tier);
+                    const auto now = ClockManager::instance().now();
+                    for (Player* pPlayer : vecNewTeam)
+                    {
+                        refTierStats.m_teamWaitHistogram.record(std::chrono::duration_cast<std::chrono::microseconds>(now - pPlayer->getQueueEnterTime()).count());
+                        pPlayer->setTeamEnterTime(now);
+                    }
+                    refTierStats.m_queuedTeams.fetch_add(1, std::memory_order_relaxed);
                     m_battleMatchQueue.addTeam(vecNewTeam);
                 }
                 else 
@@ -373,11 +622,14 @@ void BattleManager::matchmakingThread()
                 }
             }
         }
+        formTeamsSpan.end();
 
         // team to battle
+        TraceSpan startBattlesSpan("matchmaking.startBattles");
         std::vector<uint32_t> tiersToStartBattles;
         {
-            std::lock_guard<std::mutex> lock(m_battleMatchQueue.mutex);
+            TRACE_SPAN("matchmaking.lockBattleQueue");
+            std::lock_guard<ProfiledMutex> lock(m_battleMatchQueue.mutex);
             for (const auto& queuePair : m_battleMatchQueue.m_mapTierQueues)
             {
                 tiersToStartBattles.emplace_back(queuePair.first);
@@ -392,48 +644,48 @@ void BattleManager::matchmakingThread()
 
                 if (vecBattleTeams.size() == battle::TeamColor::TeamColorMax)
                 {
-                    std::cout << "\nMatched 2 teams for tier " << tier << ". Initiating battle!\n";
+                    {
+                        TRACE_SPAN("matchmaking.log");
+                        LOG_DEBUG("\nMatched 2 teams for tier {}. Initiating battle!", tier);
+                    }
+
+                    TierQueueStats& refTierStats = _getTierStats(tier);
+                    const auto now = ClockManager::instance().now();
+                    int64_t matchedPlayers = 0;
+                    for (const auto& vecTeam : vecBattleTeams)
+                    {
+                        if (!vecTeam.empty() && vecTeam[0])
+                        {
+                            refTierStats.m_battleWaitHistogram.record(std::chrono::duration_cast<std::chrono::microseconds>(now - vecTeam[0]->getTeamEnterTime()).count());
+                        }
+                        matchedPlayers += static_cast<int64_t>(vecTeam.size());
+                    }
+                    refTierStats.m_queuedTeams.fetch_sub(battle::TeamColor::TeamColorMax, std::memory_order_relaxed);
+                    refTierStats.m_queuedPlayers.fetch_sub(matchedPlayers, std::memory_order_relaxed);
 
                     std::unique_ptr<BattleRoom> uRoom;
                     uint64_t roomIdForThread = 0;
 
 					// create a new BattleRoom and add it to the map
                     {
-                        std::lock_guard<std::mutex> lock(m_battleRoomsMutex);
+						TRACE_SPAN("matchmaking.createRoom");  // room lock wait and BattleRoom construction
+                        std::lock_guard<ProfiledMutex> lock(m_battleRoomsMutex);
                         uRoom = std::make_unique<BattleRoom>(vecBattleTeams[battle::TeamColor::TeamColorRed], vecBattleTeams[battle::TeamColor::TeamColorBlue]);
 						roomIdForThread = uRoom->getRoomId();   // get the room id in automatic way
                         m_battleRooms[roomIdForThread] = std::move(uRoom);
+                        m_activeRooms.fetch_add(1, std::memory_order_relaxed);
                     }
                     // release lock m_battleRoomsMutex
 
-					// new thread for battle
-                    std::thread battle_thread([roomIdForThread]() 
-                        {
-                        BattleRoom* pBattleRoom = nullptr;
-                        {
-                            std::lock_guard<std::mutex> lock(BattleManager::instance().m_battleRoomsMutex);
-                            auto it = BattleManager::instance().m_battleRooms.find(roomIdForThread);
-                            if (it != BattleManager::instance().m_battleRooms.end()) 
-                            {
-                                pBattleRoom = it->second.get();
-                            }
-                        }
-						// release lock m_battleRoomsMutex
-
-                        if (pBattleRoom) 
-                        {
-                            pBattleRoom->startBattle();
-                        }
-                        else 
-                        {
-                            std::cerr << "[ERROR] "
-                                << "[" << __FILE__ << ":" << __LINE__ << "] "
-                                << "[" << __func__ << "] "
-								<< "BattleRoom not found for roomId : " << roomIdForThread
-                                << std::endl;
-                        }
-                        });
-					battle_thread.detach(); // detach the thread to run independently
+					// run the battle on the executor
+                    if (!ExecutorManager::instance().submit([roomIdForThread]() { BattleManager::instance().runBattle(roomIdForThread); }))
+                    {
+                        std::cerr << "[ERROR] "
+                            << "[" << __FILE__ << ":" << __LINE__ << "] "
+                            << "[" << __func__ << "] "
+                            << "Executor is not running, battle not started for roomId : " << roomIdForThread
+                            << std::endl;
+                    }
                 }
                 else 
                 {
@@ -445,8 +697,29 @@ void BattleManager::matchmakingThread()
                 }
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        startBattlesSpan.end();
+        passSpan.end();
+
+		// rooms/sec gauge
+        const auto now = ClockManager::instance().now();
+        if (now - rateWindowBegin >= ROOMS_RATE_WINDOW)
+        {
+            const uint64_t startedBattles = getStartedBattles();
+            m_roomsPerSec.store((startedBattles - rateWindowRooms) / std::chrono::duration<double>(now - rateWindowBegin).count(), std::memory_order_relaxed);
+            rateWindowBegin = now;
+            rateWindowRooms = startedBattles;
+        }
+
+        if (m_matchmakingInterval.count() > 0)
+        {
+            ClockManager::instance().sleepFor(m_matchmakingInterval);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
     }
+    ClockManager::instance().detachThread();
 
     std::cout << "[BattleManager] : Matchmaking thread stopped" << std::endl;
 }
\ No newline at end of file
@@ -5,22 +5,32 @@
 #include "../objects/hero.h"
 #include <vector>
 #include <map>
+#include <queue>
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include "../../utils/histogram.h"
+#include "../../utils/counter.h"
+#include "../../utils/profiledMutex.h"
+#include "scheduleManager.h"
 
 class BattleRoom
 {
 public:
     BattleRoom(const std::vector<Player*>& refVecTeamRed, const std::vector<Player*>& refVecTeamBlue);
     ~BattleRoom();
+	// announce the teams, the battle timer of BattleManager ends the battle
     void startBattle();
+	// roll the result and update the players, the caller owns the room (already out of BattleManager)
+    void endBattle();
     void finishBattle();
 
     uint64_t getRoomId() const { return m_roomId; }
 
 private:
     uint64_t m_roomId;
+	uint32_t m_tier = 0;    // matched tier
     std::vector<std::unique_ptr<Hero>> m_vecTeamRed;
     std::vector<std::unique_ptr<Hero>> m_vecTeamBlue;
 };
@@ -39,7 +49,7 @@ public:
     const std::map<uint32_t/* tier */, std::vector<Player*>> getTierQueue() const;
     void clear();
 
-    mutable std::mutex mutex;
+    mutable ProfiledMutex mutex{ "TeamMatchQueue::mutex" };
 
 private:
 	// private method without lock
@@ -62,7 +72,7 @@ public:
     const std::map<uint32_t/* tier */, std::vector<std::vector<Player*>>> getTierQueue() const;
     void clear();
 
-    mutable std::mutex mutex;
+    mutable ProfiledMutex mutex{ "BattleMatchQueue::mutex" };
 
 private:
     // private method without lock
@@ -71,6 +81,15 @@ private:
     std::map<uint32_t, std::vector<std::vector<Player*>>> m_mapTierQueues;
 };
 
+// queue statistics of one tier, updated lock-free by the matchmaking path
+struct TierQueueStats
+{
+	std::atomic<int64_t> m_queuedPlayers = 0;   // players in the team and battle queues
+	std::atomic<int64_t> m_queuedTeams = 0;     // teams in the battle queue
+	LatencyHistogram m_teamWaitHistogram;       // player joined the queue -> team formed (us)
+	LatencyHistogram m_battleWaitHistogram;     // team formed -> battle room created (us)
+};
+
 class BattleManager
 {
 public:
@@ -79,17 +98,52 @@ public:
     bool initialize();
     void release();
 
+	// also starts the battle timer
     void startMatchmaking();
     void stopMatchmaking();
+	// no battle is ended any more, the rooms left are dropped by release
+    void stopBattleTimer();
+	// pause between two matchmaking passes, set before startMatchmaking (0 : passes back to back, benchmarks)
+    void setMatchmakingInterval(std::chrono::milliseconds interval) { m_matchmakingInterval = interval; }
 
     void addPlayerToQueue(Player* pPlayer);
+	// put the players of a finished battle back into the queue (load generator)
+    void requeuePlayers(const std::vector<uint64_t>& refVecPlayerIds);
+    void setAutoRequeue(bool isAutoRequeue) { m_isAutoRequeue = isAutoRequeue; }
+    bool isAutoRequeue() const { return m_isAutoRequeue.load(); }
 
-    void handlePlayerWin(uint64_t playerId);
-    void handlePlayerLose(uint64_t playerId);
+	// returns the score added / subtracted
+    uint32_t handlePlayerWin(uint64_t playerId);
+    uint32_t handlePlayerLose(uint64_t playerId);
 
 	uint64_t getNextRoomId();   // get auto increment roomID
-
-    void removeBattleRoom(uint64_t roomId);
+    uint64_t getStartedBattles() const { return m_nextRoomId.load() - 1; }
+    uint64_t getFinishedBattles() const { return m_finishedBattles.load(std::memory_order_relaxed); }
+	// players waiting in the team and battle queues (gauge, no queue lock)
+    size_t getQueuedPlayers() const;
+	// players put into the queue
+    uint64_t getEnqueuedPlayers() const { return m_enqueuedPlayers.get(); }
+	// battle rooms created and not yet removed
+    int64_t getActiveRooms() const { return m_activeRooms.load(std::memory_order_relaxed); }
+	// rooms created per second, over the last second of the matchmaking thread
+    double getRoomsPerSec() const { return m_roomsPerSec.load(std::memory_order_relaxed); }
+	// tier : battle::Tier::TierMin ~ battle::Tier::TierMax
+    const TierQueueStats& getTierStats(uint32_t tier) const { return m_arrTierStats[(tier <= battle::Tier::TierMax) ? tier : battle::Tier::TierNone]; }
+	// clear the wait histograms (the gauges keep counting)
+    void resetWaitStats();
+	// empty the team and battle queues, the waiting players go back to the lobby (benchmarks)
+    void clearQueues();
+	// time from joining the queue to entering a battle room (us)
+    LatencyHistogram& getQueueWaitHistogram() { return m_queueWaitHistogram; }
+    void recordQueueWait(uint64_t waitUs);
+	// keep every queue wait exactly as well until taken, for percentiles without the histogram buckets (benchmarks)
+    void setQueueWaitSampling(bool isEnabled);
+    void takeQueueWaitSamples(std::vector<uint64_t>& refVecSamples);
+
+	// run the battle of a room on the executor
+    void runBattle(uint64_t roomId);
+	// called for a battle whose time is up, takes the room out of the map and ends it
+    void endBattle(uint64_t roomId);
 
     const TeamMatchQueue* getTeamMatchQueue() const { return &m_teamMatchQueue; }
     const BattleMatchQueue* getBattleMatchQueue() const { return &m_battleMatchQueue; }
@@ -104,18 +158,37 @@ private:
     BattleManager& operator=(BattleManager&&) = delete;
 
     void matchmakingThread();
+    TierQueueStats& _getTierStats(uint32_t tier) { return m_arrTierStats[(tier <= battle::Tier::TierMax) ? tier : battle::Tier::TierNone]; }
+	// the queues are empty, zero the queue gauges
+    void _resetQueueGauges();
+	// battle timer callback, ends the battles whose time is up on the executor
+    void _endDueBattles();
 
 	std::atomic<bool> m_isRunning = false;  // matchmaking thread running flag
 	std::thread m_matchmakingThreadHandle;  // thread for matchmaking
+	std::chrono::milliseconds m_matchmakingInterval{ 100 };    // pause between two passes
 
 	TeamMatchQueue m_teamMatchQueue{};      // queue for player match to team
 	BattleMatchQueue m_battleMatchQueue{};  // queue for team mathch to battle
 
     std::map<uint64_t/* roomId */, std::unique_ptr<BattleRoom>> m_battleRooms{};
+    using BattleEnd = std::pair<std::chrono::steady_clock::time_point, uint64_t/* roomId */>;
+	std::priority_queue<BattleEnd, std::vector<BattleEnd>, std::greater<BattleEnd>> m_queBattleEnds{};  // running battles, the earliest end on top
+	ScheduledTaskHandle m_battleTimer{};    // one repeating task for all rooms, not one task per room
     
 	std::atomic<uint64_t> m_nextRoomId = 1; // auto increment room ID
-	std::mutex m_playerAddQueueMutex;       // lock for add player to queue
-	std::mutex m_battleRoomsMutex;          // lock for battle rooms
+	std::atomic<uint64_t> m_finishedBattles = 0;
+	std::atomic<bool> m_isAutoRequeue = false;  // players join the queue again after their battle
+	LatencyHistogram m_queueWaitHistogram;
+	std::atomic<bool> m_isQueueWaitSampling = false;
+	std::vector<uint64_t> m_vecQueueWaitSamples{};  // queue waits (us) while sampling
+	std::mutex m_queueWaitSamplesMutex;             // lock for m_vecQueueWaitSamples
+	TierQueueStats m_arrTierStats[battle::Tier::TierMax + 1];  // index : tier
+	std::atomic<int64_t> m_activeRooms = 0;
+	ShardedCounter m_enqueuedPlayers;
+	std::atomic<double> m_roomsPerSec = 0.0;
+	ProfiledMutex m_playerAddQueueMutex{ "BattleManager::m_playerAddQueueMutex" };  // lock for add player to queue
+	ProfiledMutex m_battleRoomsMutex{ "BattleManager::m_battleRoomsMutex" };  // lock for battle rooms, m_queBattleEnds
 };
 
 #endif // BATTLE_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,337 @@
+// @file  : clockManager.cpp
+// @brief : real-time / virtual clock, cached coarse timestamp and high-resolution tick timer
+// @author: August
+// @date  : 2025-06-15
+#include "clockManager.h"
+#include <iostream>
+#include <algorithm>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CLOCK_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CLOCK_HAS_TSC 1
+#endif
+
+const std::chrono::milliseconds CLOCK_TICK_INTERVAL(10);            // refresh of the coarse timestamp
+const std::chrono::milliseconds CLOCK_INITIAL_CALIBRATION(10);      // first tick rate measurement in initialize
+const uint32_t CLOCK_CALIBRATION_TICKS = 100;                       // refine the tick rate every 100 ticks (1 s)
+
+// the calling thread is a participant of the virtual time
+static thread_local bool t_isAttached = false;
+
+ClockManager& ClockManager::instance()
+{
+    static ClockManager instance;
+    return instance;
+}
+
+ClockManager::ClockManager()
+{
+}
+
+ClockManager::~ClockManager()
+{
+}
+
+bool ClockManager::initialize(timing::ClockMode mode)
+{
+    if (m_running)
+    {
+        return true;
+    }
+
+	// a short first measurement, the tick thread refines it over a longer span
+    m_calibrationTicks = getTicks();
+    m_calibrationTime = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(CLOCK_INITIAL_CALIBRATION);
+    _calibrate();
+
+    m_coarseTimestampMs = time_utils::getTimestampMS();
+    m_isVirtual = (mode == timing::ClockMode::ClockModeVirtual);
+    if (m_isVirtual)
+    {
+        m_virtualBase = std::chrono::steady_clock::now();
+        m_virtualEpochMs = time_utils::getTimestampMS();
+        m_virtualElapsed = 0;
+        m_busyCounts = 0;
+        m_vecSleepers.clear();
+    }
+    m_running = true;
+    m_tickThread = m_isVirtual ? std::thread(&ClockManager::simulationLoop, this) : std::thread(&ClockManager::tickLoop, this);
+
+    std::cout << "[ClockManager] : initialized! (" << (m_isVirtual ? "virtual" : "real") << " time, "
+        << (isTscTimer() ? "tsc" : "steady_clock") << " timer, " << m_nsPerTick.load() << " ns/tick)" << std::endl;
+    return true;
+}
+
+void ClockManager::release()
+{
+    std::vector<WakeTarget> vecWakeTargets;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        for (Sleeper* pSleeper : m_vecSleepers)
+        {
+            pSleeper->m_isWoken = true;
+            vecWakeTargets.emplace_back(pSleeper->m_pCv, pSleeper->m_pMutex);
+        }
+    }
+    m_cvTick.notify_all();
+    if (m_tickThread.joinable())
+    {
+        m_tickThread.join();
+    }
+
+	// threads still waiting for the virtual time return, the time stands still from now on
+    for (const auto& target : vecWakeTargets)
+    {
+        std::lock_guard<std::mutex> lock(*target.second);
+        target.first->notify_all();
+    }
+    std::cout << "[ClockManager] : released!" << std::endl;
+}
+
+void ClockManager::sleepFor(Duration duration)
+{
+    if (!isVirtual())
+    {
+        std::this_thread::sleep_for(duration);
+        return;
+    }
+    const TimePoint wakeTime = now() + duration;
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    while (now() < wakeTime && m_running)
+    {
+        waitUntil(lock, m_cvSleep, wakeTime);
+    }
+}
+
+bool ClockManager::waitUntil(std::unique_lock<std::mutex>& refLock, std::condition_variable& refCv, TimePoint wakeTime)
+{
+    if (!isVirtual() || !m_running)
+    {
+        if (wakeTime == TimePoint::max())
+        {
+            refCv.wait(refLock);
+            return false;
+        }
+        return refCv.wait_until(refLock, wakeTime) == std::cv_status::timeout;
+    }
+
+    Sleeper sleeper;
+    sleeper.m_wakeTime = wakeTime;
+    sleeper.m_pCv = &refCv;
+    sleeper.m_pMutex = refLock.mutex();
+    sleeper.m_isAttached = t_isAttached;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (wakeTime <= now())
+        {
+            return true;
+        }
+        m_vecSleepers.emplace_back(&sleeper);
+        if (sleeper.m_isAttached)
+        {
+            _decreaseBusyNoLock();
+        }
+        m_cvTick.notify_one();
+    }
+
+	// the clock notifies with the mutex of refCv held, nothing is missed between the registration and the wait
+    refCv.wait(refLock);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_vecSleepers.erase(std::remove(m_vecSleepers.begin(), m_vecSleepers.end(), &sleeper), m_vecSleepers.end());
+    if (!sleeper.m_isWoken && sleeper.m_isAttached)
+    {
+		// spurious wake-up, busy again
+        m_busyCounts++;
+    }
+    return wakeTime <= now();
+}
+
+void ClockManager::notifyAll(std::condition_variable& refCv)
+{
+    if (isVirtual())
+    {
+		// count the woken participants as busy before they run, the time must not move on meanwhile
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Sleeper* pSleeper : m_vecSleepers)
+        {
+            if (pSleeper->m_pCv == &refCv && !pSleeper->m_isWoken)
+            {
+                pSleeper->m_isWoken = true;
+                if (pSleeper->m_isAttached)
+                {
+                    m_busyCounts++;
+                }
+            }
+        }
+    }
+    refCv.notify_all();
+}
+
+void ClockManager::attachThread()
+{
+    if (!isVirtual())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_busyCounts++;
+    t_isAttached = true;
+}
+
+void ClockManager::detachThread()
+{
+    if (!isVirtual() || !t_isAttached)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    t_isAttached = false;
+    _decreaseBusyNoLock();
+}
+
+void ClockManager::beginWork()
+{
+    if (!isVirtual())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_busyCounts++;
+}
+
+void ClockManager::endWork()
+{
+    if (!isVirtual())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    _decreaseBusyNoLock();
+}
+
+void ClockManager::_decreaseBusyNoLock()
+{
+    if (--m_busyCounts <= 0)
+    {
+        m_cvTick.notify_one();
+    }
+}
+
+uint64_t ClockManager::getTicks()
+{
+#ifdef CLOCK_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+bool ClockManager::isTscTimer()
+{
+#ifdef CLOCK_HAS_TSC
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ClockManager::_calibrate()
+{
+    if (!isTscTimer())
+    {
+        m_nsPerTick = 1.0;
+        return;
+    }
+    const uint64_t elapsedTicks = getTicks() - m_calibrationTicks;
+    const auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_calibrationTime).count();
+    if (elapsedTicks > 0 && elapsedNs > 0)
+    {
+        m_nsPerTick = static_cast<double>(elapsedNs) / static_cast<double>(elapsedTicks);
+    }
+}
+
+// handler for the tick thread (real time)
+void ClockManager::tickLoop()
+{
+    uint32_t tickCounts = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running)
+    {
+        m_cvTick.wait_for(lock, CLOCK_TICK_INTERVAL, [this]() { return !m_running.load(); });
+        m_coarseTimestampMs.store(time_utils::getTimestampMS(), std::memory_order_relaxed);
+        if (++tickCounts % CLOCK_CALIBRATION_TICKS == 0)
+        {
+            _calibrate();
+        }
+    }
+}
+
+// handler for the simulation thread (virtual time)
+void ClockManager::simulationLoop()
+{
+    std::vector<WakeTarget> vecWakeTargets;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+		// earliest wake-up of the waiting threads, TimePoint::max() if none
+        TimePoint nextWakeTime = TimePoint::max();
+        m_cvTick.wait(lock, [this, &nextWakeTime]()
+            {
+                if (!m_running)
+                {
+                    return true;
+                }
+                if (m_busyCounts > 0)
+                {
+                    return false;
+                }
+                nextWakeTime = TimePoint::max();
+                for (const Sleeper* pSleeper : m_vecSleepers)
+                {
+                    if (!pSleeper->m_isWoken)
+                    {
+                        nextWakeTime = std::min(nextWakeTime, pSleeper->m_wakeTime);
+                    }
+                }
+                return nextWakeTime != TimePoint::max();
+            });
+        if (!m_running)
+        {
+            break;
+        }
+
+		// everything waits : jump to the next event
+        if (nextWakeTime > now())
+        {
+            m_virtualElapsed.store((nextWakeTime - m_virtualBase).count(), std::memory_order_release);
+        }
+        vecWakeTargets.clear();
+        for (Sleeper* pSleeper : m_vecSleepers)
+        {
+            if (!pSleeper->m_isWoken && pSleeper->m_wakeTime <= nextWakeTime)
+            {
+                pSleeper->m_isWoken = true;
+                if (pSleeper->m_isAttached)
+                {
+                    m_busyCounts++;
+                }
+                vecWakeTargets.emplace_back(pSleeper->m_pCv, pSleeper->m_pMutex);
+            }
+        }
+
+		// notify without the clock lock (waiters take their own lock first, then the clock lock)
+		// a sleeper may be gone by now, only its cv and mutex (members of long-lived managers) are used
+        lock.unlock();
+        for (const auto& target : vecWakeTargets)
+        {
+            std::lock_guard<std::mutex> sleeperLock(*target.second);
+            target.first->notify_all();
+        }
+        lock.lock();
+    }
+}
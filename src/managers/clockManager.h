@@ -0,0 +1,124 @@
+// clockManager.h
+#ifndef CLOCK_MANAGER_H
+#define CLOCK_MANAGER_H
+
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "../../include/globalDefine.h"
+#include "../../utils/utils.h"
+
+// time source of the server, every "now", sleep and timed wait of the battle, schedule and command code goes through it
+// - real time : a coarse wall-clock timestamp in milliseconds cached by a tick thread (a relaxed atomic load to read),
+//   sleeps and waits take real time
+// - virtual time : a discrete-event simulation, the clock stands still while anything runs and jumps to the earliest
+//   wake-up as soon as every participant waits. "participants" are the threads that called attachThread()
+//   and the work items announced by beginWork() (executor tasks, long-running schedule tasks)
+// also a high-resolution monotonic tick counter for latency measurement (TSC on x86, steady_clock elsewhere),
+// converted to nanoseconds with a rate calibrated against steady_clock and refined by the tick thread (real time, never virtual)
+class ClockManager
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Duration = std::chrono::steady_clock::duration;
+
+    static ClockManager& instance();
+
+    bool initialize(timing::ClockMode mode = timing::ClockMode::ClockModeRealTime);
+    void release();
+
+    bool isVirtual() const { return m_isVirtual.load(std::memory_order_relaxed); }
+
+	// monotonic time, replaces std::chrono::steady_clock::now()
+    TimePoint now() const
+    {
+        return isVirtual() ? (m_virtualBase + Duration(m_virtualElapsed.load(std::memory_order_acquire))) : std::chrono::steady_clock::now();
+    }
+	// wall clock in milliseconds, at most one tick interval old (exact time_utils::getTimestampMS when not running)
+    uint64_t getTimestampMS() const
+    {
+        if (isVirtual())
+        {
+            return m_virtualEpochMs + static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Duration(m_virtualElapsed.load(std::memory_order_acquire))).count());
+        }
+        return m_running.load(std::memory_order_relaxed) ? m_coarseTimestampMs.load(std::memory_order_relaxed) : time_utils::getTimestampMS();
+    }
+
+	// replaces std::this_thread::sleep_for
+    void sleepFor(Duration duration);
+	// replaces refCv.wait_until(refLock, wakeTime), TimePoint::max() waits for a notify only
+	// returns false if woken up by notifyAll (or spuriously) before wakeTime
+    bool waitUntil(std::unique_lock<std::mutex>& refLock, std::condition_variable& refCv, TimePoint wakeTime);
+	// replaces refCv.notify_all() for a cv waited on with waitUntil, call it with the mutex of refCv held
+    void notifyAll(std::condition_variable& refCv);
+
+	// virtual time : the calling thread takes part in the simulation (the clock waits for it), no-op in real time
+    void attachThread();
+    void detachThread();
+	// virtual time : a work item was queued / has finished, the clock stands still in between, no-op in real time
+    void beginWork();
+    void endWork();
+
+	// monotonic ticks, only the difference of two readings is meaningful
+    static uint64_t getTicks();
+	// convert a tick difference to time
+    uint64_t ticksToNs(uint64_t ticks) const { return static_cast<uint64_t>(static_cast<double>(ticks) * m_nsPerTick.load(std::memory_order_relaxed)); }
+    uint64_t ticksToUs(uint64_t ticks) const { return ticksToNs(ticks) / 1000; }
+	// getTicks reads the cpu time-stamp counter
+    static bool isTscTimer();
+
+private:
+    ClockManager();
+    ~ClockManager();
+
+    ClockManager(const ClockManager&) = delete;
+    ClockManager& operator=(const ClockManager&) = delete;
+    ClockManager(ClockManager&&) = delete;
+    ClockManager& operator=(ClockManager&&) = delete;
+
+	// a thread blocked in waitUntil in virtual time, lives on the stack of that thread
+    struct Sleeper
+    {
+        TimePoint m_wakeTime{};
+        std::condition_variable* m_pCv = nullptr;
+        std::mutex* m_pMutex = nullptr;
+		bool m_isAttached = false;      // counted in m_busyCounts while awake
+		bool m_isWoken = false;         // woken by the clock or notifyAll, already counted as busy again
+    };
+
+    using WakeTarget = std::pair<std::condition_variable*, std::mutex*>;
+
+    void tickLoop();
+	// virtual time : wait until every participant waits, then move the time to the earliest wake-up
+    void simulationLoop();
+	// nanoseconds per tick since the calibration start
+    void _calibrate();
+	// wake the simulation loop when the last participant starts to wait
+    void _decreaseBusyNoLock();
+
+	std::atomic<uint64_t> m_coarseTimestampMs = 0;
+	std::atomic<double> m_nsPerTick = 1.0;
+	uint64_t m_calibrationTicks = 0;                            // getTicks at the calibration start
+	TimePoint m_calibrationTime{};                              // steady_clock at the calibration start
+
+	std::atomic<bool> m_isVirtual = false;
+	TimePoint m_virtualBase{};                                  // virtual time 0
+	uint64_t m_virtualEpochMs = 0;                              // wall clock at virtual time 0
+	std::atomic<Duration::rep> m_virtualElapsed = 0;            // virtual time since m_virtualBase
+	std::vector<Sleeper*> m_vecSleepers{};                      // threads waiting for the virtual time
+	int64_t m_busyCounts = 0;                                   // awake participants and unfinished work items
+
+	std::mutex m_mutex;                 // lock for m_cvTick, the virtual time state
+	std::condition_variable m_cvTick;   // wake up the tick / simulation thread
+	std::mutex m_sleepMutex;            // lock for m_cvSleep
+	std::condition_variable m_cvSleep;  // sleepFor waits on it
+	std::thread m_tickThread;
+	std::atomic<bool> m_running = false;
+};
+
+#endif // CLOCK_MANAGER_H
@@ -4,16 +4,81 @@
 // @date  : 2025-05-15
 #include "dbManager.h"
 #include "playerManager.h"
+#include "snapshotManager.h"
+#include "historyManager.h"
+#include "executorManager.h"
+#include "traceManager.h"
 #include "../../libs/sqlite/sqlite3.h"
 #include "../../utils/utils.h"
+#include "../../include/globalDefine.h"
 #include <iostream>
 #include <chrono>
+#include <thread>
+#include <algorithm>
+#include <unordered_set>
 
 // create table sql statements
 std::unordered_map<std::string, std::string> MAP_CREATE_TABLE_SQL = {
     {"player_battles", "CREATE TABLE IF NOT EXISTS player_battles (id INTEGER PRIMARY KEY, score INTEGER, wins INTEGER, updated_time INTEGER)"},
+    {"battle_history", "CREATE TABLE IF NOT EXISTS battle_history (id INTEGER PRIMARY KEY, room_id INTEGER, battle_time INTEGER, tier INTEGER, red_team TEXT, blue_team TEXT, winner INTEGER)"},
+	// clustered by (player_id, battle_time), the latest battles of a player are one range scan
+    {"battle_history_players", "CREATE TABLE IF NOT EXISTS battle_history_players (player_id INTEGER, battle_time INTEGER, battle_id INTEGER, team INTEGER, score_delta INTEGER, PRIMARY KEY (player_id, battle_time, battle_id)) WITHOUT ROWID"},
+    {"db_meta", "CREATE TABLE IF NOT EXISTS db_meta (key TEXT PRIMARY KEY, value INTEGER)"},
 };
 
+// tables split by player id over all shards, the other tables only live in shard 0
+const std::unordered_set<std::string> SET_SHARDED_TABLES = { "player_battles" };
+
+// create index sql statements, created after tables
+std::unordered_map<std::string, std::pair<std::string/* table name */, std::string/* sql */>> MAP_CREATE_INDEX_SQL = {
+    {"idx_player_battles_updated_time", {"player_battles", "CREATE INDEX IF NOT EXISTS idx_player_battles_updated_time ON player_battles (updated_time)"}},
+    {"idx_battle_history_battle_time", {"battle_history", "CREATE INDEX IF NOT EXISTS idx_battle_history_battle_time ON battle_history (battle_time)"}},
+};
+
+// reader threads for async queries, each owns one read-only connection per shard
+const uint32_t DB_READER_THREADS = 4;
+// wait for the other connections instead of failing with SQLITE_BUSY
+const int DB_READER_BUSY_TIMEOUT_MS = 1000;
+// WAL lets the readers keep reading while the writer commits, NORMAL syncs only at checkpoints
+const char* DB_SHARD_PRAGMA_SQL = "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;";
+// pages copied per backup step, the shard lock is held only during one step
+const int BACKUP_STEP_PAGES = 256;
+// sleep between backup steps so writers are not starved
+const std::chrono::milliseconds BACKUP_STEP_YIELD(10);
+
+// max ids in one "IN (...)" query (keep bound parameters under SQLITE_MAX_VARIABLE_NUMBER 999)
+const size_t QUERY_IN_MAX_IDS = 500;
+
+// max rows in one multi-row insert statement (keep bound parameters under SQLITE_MAX_VARIABLE_NUMBER 999)
+const size_t MULTI_ROW_INSERT_MAX_ROWS = 100;
+
+// build "INSERT INTO <table> (<columns>) VALUES (?,...),(?,...)..." for rowCounts rows
+static std::string buildMultiRowInsertSql(const std::string& tableName, const std::string& columns, size_t columnCounts, size_t rowCounts)
+{
+    std::string rowPlaceholder = "(";
+    for (size_t i = 0; i < columnCounts; i++)
+    {
+        rowPlaceholder += (i == 0) ? "?" : ",?";
+    }
+    rowPlaceholder += ")";
+
+    std::string sql = "INSERT INTO " + tableName + " (" + columns + ") VALUES ";
+    sql.reserve(sql.size() + rowCounts * (rowPlaceholder.size() + 1));
+    for (size_t i = 0; i < rowCounts; i++)
+    {
+        if (i > 0)
+        {
+            sql += ",";
+        }
+        sql += rowPlaceholder;
+    }
+    sql += ";";
+    return sql;
+}
+
+// min rows for each partition when loading player_battles in parallel
+const uint64_t LOAD_MIN_ROWS_PER_PARTITION = 50000;
+
 DbManager& DbManager::instance()
 {
     static DbManager instance;
@@ -21,7 +86,7 @@ DbManager& DbManager::instance()
 }
 
 DbManager::DbManager()
-    : m_dbHandler(nullptr), m_dbName("gameMatch.db")
+    : m_dbName("gameMatch.db")
 {
 }
 
@@ -29,108 +94,497 @@ DbManager::~DbManager()
 {
 }
 
+void DbManager::configure(const std::string& dbName, uint32_t shardCounts)
+{
+    m_dbName = dbName;
+    m_shardCounts = std::max<uint32_t>(1, shardCounts);
+}
+
 bool DbManager::initialize()
 {
 	m_mapFuncSyncData.clear();
-    m_mapFuncSyncData["player_battles"] = [this]() { this->syncAllPlayerBattles(); };
-    if (m_dbHandler)
-    {
-        sqlite3_close(m_dbHandler);
-        m_dbHandler = nullptr;
-    }
+    m_mapFuncSyncData["player_battles"] = [this]() { return this->loadPlayerBattles(); };
+    _closeShards();
 	std::cout << "[DbManager] : initialized!" << std::endl;
     return true;
 }
 
 bool DbManager::connect()
 {
-    int rc = sqlite3_open(m_dbName.c_str(), &m_dbHandler);
-    if (rc != SQLITE_OK)
+    for (uint32_t i = 0; i < m_shardCounts; i++)
     {
-        std::cerr << "[ERROR] "
-            << "[" << __FILE__ << ":" << __LINE__ << "] "
-            << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
-            << std::endl;
-        m_dbHandler = nullptr;
-		return false;
+        std::unique_ptr<DbShard> uShard = std::make_unique<DbShard>();
+        uShard->m_index = i;
+        uShard->m_fileName = _getShardFileName(i);
+        int rc = sqlite3_open(uShard->m_fileName.c_str(), &uShard->m_dbHandler);
+        if (rc != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(uShard->m_dbHandler) << " (" << uShard->m_fileName << ")"
+                << std::endl;
+            sqlite3_close(uShard->m_dbHandler);
+            _closeShards();
+            return false;
+        }
+		sqlite3_busy_timeout(uShard->m_dbHandler, DB_READER_BUSY_TIMEOUT_MS);  // checkpoint or backup may still wait for the others
+        sqlite3* pHandler = uShard->m_dbHandler;
+        m_vecShards.emplace_back(std::move(uShard));
+
+        char* errMsg = nullptr;
+        if (sqlite3_exec(pHandler, DB_SHARD_PRAGMA_SQL, nullptr, nullptr, &errMsg) != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << errMsg << " (" << m_vecShards.back()->m_fileName << ")"
+                << std::endl;
+            sqlite3_free(errMsg);
+            _closeShards();
+            return false;
+        }
+
+		// check the main file before the other shard files are created
+        if (i == 0 && !_checkShardCounts())
+        {
+            _closeShards();
+            return false;
+        }
     }
-	std::cout << "[DbManager] : connect database opened successfully." << std::endl;
+	std::cout << "[DbManager] : connect database opened successfully (" << m_vecShards.size() << " shards)." << std::endl;
+
+    startWriters();
+    startReaders(DB_READER_THREADS);
     return true;
 }
 
 void DbManager::release()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+	stopReaders();  // finish the queued reads before the database is closed
 
-    if (m_dbHandler)
+    m_isBackupCanceled = true;
+    if (m_backupThread.joinable())
     {
-		// close database connection
-        sqlite3_close(m_dbHandler);
-        m_dbHandler = nullptr;
-	}
+		// wait for the backup thread to stop at the next step
+        m_backupThread.join();
+    }
+    m_isBackupCanceled = false;
+
+	stopWriters();  // finish the queued writes
+
+    _closeShards();
 	m_mapFuncSyncData.clear();
     std::cout << "[DbManager] : released!" << std::endl;
 }
 
+void DbManager::_closeShards()
+{
+    for (auto& uShard : m_vecShards)
+    {
+        std::lock_guard<ProfiledMutex> lock(uShard->m_mutex);
+        if (uShard->m_dbHandler)
+        {
+			// close database connection
+            sqlite3_close(uShard->m_dbHandler);
+            uShard->m_dbHandler = nullptr;
+        }
+    }
+    m_vecShards.clear();
+}
+
+// shard 0 is the main file, shard i is "<name>.shard<i>.db"
+std::string DbManager::_getShardFileName(uint32_t shardIndex) const
+{
+    if (shardIndex == 0)
+    {
+        return m_dbName;
+    }
+    const std::string suffix = ".db";
+    const bool hasSuffix = (m_dbName.size() > suffix.size()) && (m_dbName.compare(m_dbName.size() - suffix.size(), suffix.size(), suffix) == 0);
+    const std::string baseName = hasSuffix ? m_dbName.substr(0, m_dbName.size() - suffix.size()) : m_dbName;
+    return baseName + ".shard" + std::to_string(shardIndex) + suffix;
+}
+
+// "<shard file name without .db>.backup.db"
+std::string DbManager::_getBackupFileName(uint32_t shardIndex) const
+{
+    const std::string fileName = _getShardFileName(shardIndex);
+    const std::string suffix = ".db";
+    const bool hasSuffix = (fileName.size() > suffix.size()) && (fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0);
+    return (hasSuffix ? fileName.substr(0, fileName.size() - suffix.size()) : fileName) + ".backup.db";
+}
+
+bool DbManager::_checkShardCounts()
+{
+    DbShard* pMainShard = _getMainShard();
+    if (!pMainShard)
+    {
+        return false;
+    }
+    std::lock_guard<ProfiledMutex> lock(pMainShard->m_mutex);
+    sqlite3* pHandler = pMainShard->m_dbHandler;
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(pHandler, MAP_CREATE_TABLE_SQL["db_meta"].c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << errMsg
+            << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    int64_t storedCounts = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(pHandler, "SELECT value FROM db_meta WHERE key = 'shard_counts';", -1, &stmt, nullptr) == SQLITE_OK)
+    {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            storedCounts = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    if (storedCounts == 0)
+    {
+		// a database created before sharding keeps all players in the main file
+        bool hasPlayers = false;
+        if (sqlite3_prepare_v2(pHandler, "SELECT 1 FROM player_battles LIMIT 1;", -1, &stmt, nullptr) == SQLITE_OK)
+        {
+            hasPlayers = (sqlite3_step(stmt) == SQLITE_ROW);
+            sqlite3_finalize(stmt);
+        }
+        storedCounts = hasPlayers ? 1 : m_shardCounts;
+
+        if (sqlite3_prepare_v2(pHandler, "INSERT INTO db_meta (key, value) VALUES ('shard_counts', ?);", -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(pHandler)
+                << std::endl;
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, storedCounts);
+        const int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+			// without the stored counts the next start could open the files with another sharding
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Failed to store shard counts, SQL error: " << sqlite3_errmsg(pHandler)
+                << std::endl;
+            return false;
+        }
+    }
+
+    if (storedCounts != m_shardCounts)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Database " << m_dbName << " has " << storedCounts << " shards, but " << m_shardCounts << " shards are configured."
+            << std::endl;
+        return false;
+    }
+    return true;
+}
+
 bool DbManager::ensureTableSchema()
 {
-    for (auto& itTable : MAP_CREATE_TABLE_SQL)
+    for (uint32_t shardIndex = 0; shardIndex < m_vecShards.size(); shardIndex++)
     {
-        const std::string tableName = itTable.first;
-        if (!isTableExists(tableName))
+        for (auto& itTable : MAP_CREATE_TABLE_SQL)
         {
-            if (!createTable(tableName))
+            const std::string tableName = itTable.first;
+			// shard 0 holds all tables, the other shards only the sharded ones
+            if (shardIndex > 0 && SET_SHARDED_TABLES.count(tableName) == 0)
             {
-                std::cerr << "[ERROR] "
-                    << "[" << __FILE__ << ":" << __LINE__ << "] "
-                    << "[" << __func__ << "] "
-                    << "Failed to create table '" << tableName << "'."
-                    << std::endl;
-                return false;
+                continue;
+            }
+            if (!isTableExists(shardIndex, tableName))
+            {
+                if (!createTable(shardIndex, tableName))
+                {
+                    std::cerr << "[ERROR] "
+                        << "[" << __FILE__ << ":" << __LINE__ << "] "
+                        << "[" << __func__ << "] "
+                        << "Failed to create table '" << tableName << "' in shard " << shardIndex << "."
+                        << std::endl;
+                    return false;
+                }
             }
         }
+        if (!createIndexes(shardIndex))
+        {
+            return false;
+        }
+    }
+
+	// new player ids continue after the max id of all shards
+    m_nextPlayerId = _queryMaxPlayerId() + 1;
+    return true;
+}
+
+bool DbManager::createIndexes(uint32_t shardIndex)
+{
+    if (shardIndex >= m_vecShards.size())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Database not open."
+            << std::endl;
+        return false;
+    }
+    DbShard& refShard = *m_vecShards[shardIndex];
+    std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+
+    for (auto& itIndex : MAP_CREATE_INDEX_SQL)
+    {
+        if (shardIndex > 0 && SET_SHARDED_TABLES.count(itIndex.second.first) == 0)
+        {
+            continue;
+        }
+        char* errMsg = nullptr;
+        int rc = sqlite3_exec(refShard.m_dbHandler, itIndex.second.second.c_str(), nullptr, nullptr, &errMsg);
+        if (rc != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Failed to create index '" << itIndex.first << "', SQL error: " << errMsg
+                << std::endl;
+            sqlite3_free(errMsg);
+            return false;
+        }
     }
     return true;
 }
 
-void DbManager::loadTableData()
+// false if any table failed to load, the server must not start on partial data
+bool DbManager::loadTableData()
 {
+    bool isOk = true;
     for (auto& itFunc : m_mapFuncSyncData)
     {
 		const std::string tableName = itFunc.first;
 		// execute the function to load data from the table
-        itFunc.second();
+        if (!itFunc.second())
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Failed to load table : " << tableName
+                << std::endl;
+            isOk = false;
+        }
     }
+    return isOk;
 }
 
-// sync all player battles data from database to PlayerManager
-void DbManager::syncAllPlayerBattles()
+// load player battles from the snapshot file and replay the newer rows,
+// fall back to a full table scan if the snapshot is missing, broken or stale
+bool DbManager::loadPlayerBattles()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t snapshotTime = 0;
+    uint64_t snapshotMaxPlayerId = 0;
+    if (SnapshotManager::instance().loadSnapshot(snapshotTime, snapshotMaxPlayerId))
+    {
+        const uint64_t dbMaxPlayerId = _queryMaxPlayerId();
+        // players in the snapshot must exist in db, otherwise the snapshot belongs to another db
+        if (snapshotMaxPlayerId <= dbMaxPlayerId && syncPlayerBattlesSince(snapshotTime))
+        {
+            return true;
+        }
+        std::cerr << "[WARNING] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Snapshot does not match database, reload all player battles."
+            << std::endl;
+        PlayerManager::instance().clearPlayersNoLock();
+    }
+    return syncAllPlayerBattles();
+}
 
-    if (!m_dbHandler)
+// sync all player battles data from database to PlayerManager
+// the id range of every shard is split into partitions, each partition is scanned by its own thread on its own read connection,
+// then all partitions are merged into PlayerManager, nothing is merged if a partition fails to load
+bool DbManager::syncAllPlayerBattles()
+{
+    if (m_vecShards.empty())
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
             << "Database not open."
             << std::endl;
-        return;
+        return false;
     }
 
-    const char* sql = "SELECT id, score, wins, updated_time FROM player_battles;";
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(m_dbHandler, sql, -1, &stmt, nullptr);
+    const auto beginTime = std::chrono::steady_clock::now();
+
+    struct LoadPartition
+    {
+        std::string m_fileName = "";
+        uint64_t m_minId = 0;
+        uint64_t m_maxId = 0;
+    };
+    std::vector<LoadPartition> vecLoadPartitions;
+    uint64_t totalRowCounts = 0;
+
+	// hardware threads are shared by all shards
+    const uint64_t threadsPerShard = std::max<uint64_t>(1, std::thread::hardware_concurrency() / m_vecShards.size());
+
+    for (auto& uShard : m_vecShards)
+    {
+		// get the id range and row counts to split partitions
+        uint64_t minId = 0;
+        uint64_t maxId = 0;
+        uint64_t rowCounts = 0;
+        {
+            std::lock_guard<ProfiledMutex> lock(uShard->m_mutex);
+
+            const char* sql = "SELECT MIN(id), MAX(id), COUNT(*) FROM player_battles;";
+            sqlite3_stmt* stmt = nullptr;
+            int rc = sqlite3_prepare_v2(uShard->m_dbHandler, sql, -1, &stmt, nullptr);
+            if (rc != SQLITE_OK)
+            {
+                std::cerr << "[ERROR] "
+                    << "[" << __FILE__ << ":" << __LINE__ << "] "
+                    << "[" << __func__ << "] "
+                    << "SQL error: " << sqlite3_errmsg(uShard->m_dbHandler)
+                    << std::endl;
+                return false;
+            }
+            if (sqlite3_step(stmt) == SQLITE_ROW)
+            {
+                minId = sqlite3_column_int64(stmt, 0);
+                maxId = sqlite3_column_int64(stmt, 1);
+                rowCounts = sqlite3_column_int64(stmt, 2);
+            }
+            sqlite3_finalize(stmt);
+        }
+        if (rowCounts == 0)
+        {
+            continue;
+        }
+        totalRowCounts += rowCounts;
+
+		// partition counts : never less than LOAD_MIN_ROWS_PER_PARTITION rows each
+        const uint64_t partitionCounts = std::min<uint64_t>(threadsPerShard, std::max<uint64_t>(1, rowCounts / LOAD_MIN_ROWS_PER_PARTITION));
+        const uint64_t idSpan = maxId - minId + 1;
+        const uint64_t idStep = (idSpan + partitionCounts - 1) / partitionCounts;
+        for (uint64_t i = 0; i < partitionCounts; i++)
+        {
+            LoadPartition partition;
+            partition.m_fileName = uShard->m_fileName;
+            partition.m_minId = minId + i * idStep;
+            partition.m_maxId = (i == partitionCounts - 1) ? maxId : (partition.m_minId + idStep - 1);
+            vecLoadPartitions.emplace_back(partition);
+        }
+    }
+
+    if (totalRowCounts == 0)
+    {
+        std::cout << "[DbManager] : player_battles is empty, nothing to load." << std::endl;
+        return true;
+    }
+
+    const size_t partitionCounts = vecLoadPartitions.size();
+    std::vector<std::vector<std::unique_ptr<Player>>> vecPartitions(partitionCounts);
+    std::vector<uint8_t> vecResults(partitionCounts, 0);
+    std::vector<std::thread> vecWorkers;
+    vecWorkers.reserve(partitionCounts);
+
+    for (size_t i = 0; i < partitionCounts; i++)
+    {
+        vecWorkers.emplace_back([this, i, &vecLoadPartitions, &vecPartitions, &vecResults]()
+            {
+                const LoadPartition& partition = vecLoadPartitions[i];
+                vecResults[i] = loadPlayerBattlesRange(partition.m_fileName, partition.m_minId, partition.m_maxId, vecPartitions[i]) ? 1 : 0;
+            });
+    }
+    for (auto& worker : vecWorkers)
+    {
+        worker.join();
+    }
+
+	// scan a failed partition once more, merging without it would silently lose its players
+    for (size_t i = 0; i < partitionCounts; i++)
+    {
+        if (vecResults[i] != 0)
+        {
+            continue;
+        }
+        const LoadPartition& partition = vecLoadPartitions[i];
+        vecPartitions[i].clear();
+        if (!loadPlayerBattlesRange(partition.m_fileName, partition.m_minId, partition.m_maxId, vecPartitions[i]))
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Failed to load partition " << i << " of player_battles (" << partition.m_fileName << ", id "
+                << partition.m_minId << " - " << partition.m_maxId << ")."
+                << std::endl;
+            return false;
+        }
+    }
+
+    // merge all partitions into PlayerManager
+    uint64_t loadedRows = 0;
+    PlayerManager::instance().reservePlayersNoLock(totalRowCounts);
+    for (size_t i = 0; i < partitionCounts; i++)
+    {
+        loadedRows += vecPartitions[i].size();
+        PlayerManager::instance().mergePlayersFromDbNoLock(vecPartitions[i]);
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    const uint64_t rowsPerSec = (elapsedMs > 0) ? (loadedRows * 1000 / elapsedMs) : loadedRows;
+    std::cout << "[DbManager] : loaded " << loadedRows << " player_battles rows from " << m_vecShards.size() << " shards with "
+        << partitionCounts << " partitions in " << elapsedMs << " ms (" << rowsPerSec << " rows/sec)." << std::endl;
+    return true;
+}
+
+// load player battles in id range [minId, maxId] of a shard file with a dedicated read-only connection
+// *** runs on loader threads, must not touch the shard connections ***
+bool DbManager::loadPlayerBattlesRange(const std::string& fileName, uint64_t minId, uint64_t maxId, std::vector<std::unique_ptr<Player>>& refVecPartition)
+{
+    sqlite3* pReadHandler = nullptr;
+    int rc = sqlite3_open_v2(fileName.c_str(), &pReadHandler, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
     if (rc != SQLITE_OK)
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(pReadHandler)
             << std::endl;
-        return;
+        sqlite3_close(pReadHandler);
+        return false;
+    }
+
+    const char* sql = "SELECT id, score, wins, updated_time FROM player_battles WHERE id BETWEEN ? AND ?;";
+    sqlite3_stmt* stmt = nullptr;
+    rc = sqlite3_prepare_v2(pReadHandler, sql, -1, &stmt, nullptr);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pReadHandler)
+            << std::endl;
+        sqlite3_close(pReadHandler);
+        return false;
     }
+    sqlite3_bind_int64(stmt, 1, minId);
+    sqlite3_bind_int64(stmt, 2, maxId);
+
     uint64_t id = 0;
     uint32_t score = 0;
     uint32_t wins = 0;
@@ -145,16 +599,96 @@ void DbManager::syncAllPlayerBattles()
         {
             continue;
         }
-        PlayerManager::instance().syncPlayerFromDbNoLock(id, score, wins, updatedTime);
+        refVecPartition.emplace_back(std::make_unique<Player>(id, score, wins, updatedTime));
     }
     sqlite3_finalize(stmt);
+    sqlite3_close(pReadHandler);
+    return (rc == SQLITE_DONE);
+}
+
+// replay rows updated after the snapshot was taken (overwrite the players loaded from the snapshot)
+bool DbManager::syncPlayerBattlesSince(uint64_t updatedTime)
+{
+    TRACE_SPAN("DbManager::syncPlayerBattlesSince");
+    if (m_vecShards.empty())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Database not open."
+            << std::endl;
+        return false;
+    }
+
+    const auto beginTime = std::chrono::steady_clock::now();
+
+    uint64_t replayedRows = 0;
+    for (auto& uShard : m_vecShards)
+    {
+        std::lock_guard<ProfiledMutex> lock(uShard->m_mutex);
+
+        const char* sql = "SELECT id, score, wins, updated_time FROM player_battles WHERE updated_time >= ?;";
+        sqlite3_stmt* stmt = nullptr;
+        int rc = sqlite3_prepare_v2(uShard->m_dbHandler, sql, -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(uShard->m_dbHandler)
+                << std::endl;
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, updatedTime);
+
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            const uint64_t id = sqlite3_column_int64(stmt, 0);
+            if (id == 0)
+            {
+                continue;
+            }
+            PlayerManager::instance().replayPlayerFromDbNoLock(id, sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 2), sqlite3_column_int64(stmt, 3));
+            replayedRows++;
+        }
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            return false;
+        }
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    std::cout << "[DbManager] : replayed " << replayedRows << " player_battles rows newer than snapshot in " << elapsedMs << " ms." << std::endl;
+    return true;
 }
 
-bool DbManager::isTableExists(const std::string tableName)
+// max player id over all shards
+uint64_t DbManager::_queryMaxPlayerId()
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t maxId = 0;
+    for (auto& uShard : m_vecShards)
+    {
+        std::lock_guard<ProfiledMutex> lock(uShard->m_mutex);
+
+        const char* sql = "SELECT MAX(id) FROM player_battles;";
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(uShard->m_dbHandler, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            continue;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            maxId = std::max<uint64_t>(maxId, sqlite3_column_int64(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+    }
+    return maxId;
+}
 
-    if (!m_dbHandler) 
+bool DbManager::isTableExists(uint32_t shardIndex, const std::string tableName)
+{
+    if (shardIndex >= m_vecShards.size())
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
@@ -163,18 +697,20 @@ bool DbManager::isTableExists(const std::string tableName)
             << std::endl;
         return false;
     }
+    DbShard& refShard = *m_vecShards[shardIndex];
+    std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
 
     const char* sql = "SELECT name FROM sqlite_master WHERE type='table' AND name=?;";
     sqlite3_stmt* stmt = nullptr;
     bool exists = false;
 
-    int rc = sqlite3_prepare_v2(m_dbHandler, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) 
+    int rc = sqlite3_prepare_v2(refShard.m_dbHandler, sql, -1, &stmt, nullptr);
+    if (rc != SQLITE_OK)
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(refShard.m_dbHandler)
             << std::endl;
 
 		if (stmt) sqlite3_finalize(stmt);   // clean up the statement if it was prepared
@@ -183,7 +719,7 @@ bool DbManager::isTableExists(const std::string tableName)
 
     sqlite3_bind_text(stmt, 1, tableName.c_str(), -1, SQLITE_STATIC);
 
-    if (sqlite3_step(stmt) == SQLITE_ROW) 
+    if (sqlite3_step(stmt) == SQLITE_ROW)
     {
         exists = true;
     }
@@ -192,9 +728,9 @@ bool DbManager::isTableExists(const std::string tableName)
     return exists;
 }
 
-bool DbManager::createTable(const std::string tableName)
+bool DbManager::createTable(uint32_t shardIndex, const std::string tableName)
 {
-    if (!m_dbHandler)
+    if (shardIndex >= m_vecShards.size())
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
@@ -214,8 +750,11 @@ bool DbManager::createTable(const std::string tableName)
             << std::endl;
 		return false;
     }
+    DbShard& refShard = *m_vecShards[shardIndex];
+    std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+
     char* errMsg = nullptr;
-    int rc = sqlite3_exec(m_dbHandler, itSql->second.c_str(), nullptr, nullptr, &errMsg);
+    int rc = sqlite3_exec(refShard.m_dbHandler, itSql->second.c_str(), nullptr, nullptr, &errMsg);
 
     if (rc != SQLITE_OK)
     {
@@ -231,44 +770,44 @@ bool DbManager::createTable(const std::string tableName)
     return true;
 }
 
-uint64_t DbManager::insertPlayerBattles()
+uint64_t DbManager::insertPlayerBattles(uint32_t score, uint32_t wins, uint64_t updatedTime)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!m_dbHandler)
+    TRACE_SPAN("DbManager::insertPlayerBattles");
+    if (m_vecShards.empty())
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
             << "Database not open."
             << std::endl;
-        return false;
+        return 0;
     }
 
-	// no id in the insert statement, it will be auto-incremented
+	// the id is assigned here instead of auto-increment, so the row goes to the shard of its id
+    const uint64_t id = m_nextPlayerId.fetch_add(1);
+    DbShard& refShard = *m_vecShards[_getShardIndex(id)];
+    std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+
     const char* sql =
-        "INSERT INTO player_battles (score, wins, updated_time) "
-        "VALUES (?, ?, ?);";
+        "INSERT INTO player_battles (id, score, wins, updated_time) "
+        "VALUES (?, ?, ?, ?);";
 
     sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(m_dbHandler, sql, -1, &stmt, nullptr);
+    int rc = sqlite3_prepare_v2(refShard.m_dbHandler, sql, -1, &stmt, nullptr);
 
     if (rc != SQLITE_OK)
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(refShard.m_dbHandler)
             << std::endl;
         return 0;
     }
-    const uint32_t score = 0;
-	const uint32_t wins = 0;
-	const uint64_t updatedTime = time_utils::getTimestampMS();
-
-    sqlite3_bind_int(stmt, 1, score);
-    sqlite3_bind_int(stmt, 2, wins);
-    sqlite3_bind_int64(stmt, 3, updatedTime);
+    sqlite3_bind_int64(stmt, 1, id);
+    sqlite3_bind_int(stmt, 2, score);
+    sqlite3_bind_int(stmt, 3, wins);
+    sqlite3_bind_int64(stmt, 4, updatedTime);
 
     rc = sqlite3_step(stmt);
 	sqlite3_finalize(stmt); // clean up the statement
@@ -278,27 +817,124 @@ uint64_t DbManager::insertPlayerBattles()
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(refShard.m_dbHandler)
             << std::endl;
         return 0;
     }
-
-	// get the last inserted row id after the insert operation
-    uint64_t id = sqlite3_last_insert_rowid(m_dbHandler);
-    if (id == 0)
+    return id;
+}
+
+// insert player rows with multi-row inserts in one transaction on the given connection
+static bool insertPlayerBattlesOn(sqlite3* pHandler, const std::vector<PlayerRecord>& refVecRecords)
+{
+    TRACE_SPAN("db.insertPlayerBattlesOn");
+    if (!pHandler)
     {
-        return 0;
+        return false;
     }
-	// sync the player data to PlayerManager
-	PlayerManager::instance().syncPlayerFromDbNoLock(id, score, wins, updatedTime);
-    return id;
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(pHandler, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << errMsg
+            << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    bool isOk = true;
+    for (size_t offset = 0; isOk && offset < refVecRecords.size(); offset += MULTI_ROW_INSERT_MAX_ROWS)
+    {
+        const size_t rowCounts = std::min(MULTI_ROW_INSERT_MAX_ROWS, refVecRecords.size() - offset);
+        const std::string sql = buildMultiRowInsertSql("player_battles", "id, score, wins, updated_time", 4, rowCounts);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(pHandler, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            isOk = false;
+            break;
+        }
+        int bindIndex = 1;
+        for (size_t i = offset; i < offset + rowCounts; i++)
+        {
+            const PlayerRecord& record = refVecRecords[i];
+            sqlite3_bind_int64(stmt, bindIndex++, record.m_id);
+            sqlite3_bind_int(stmt, bindIndex++, record.m_score);
+            sqlite3_bind_int(stmt, bindIndex++, record.m_wins);
+            sqlite3_bind_int64(stmt, bindIndex++, record.m_updatedTime);
+        }
+        isOk = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_finalize(stmt);
+    }
+
+    if (!isOk)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pHandler)
+            << std::endl;
+    }
+    rc = sqlite3_exec(pHandler, isOk ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+    return isOk && (rc == SQLITE_OK);
 }
 
-bool DbManager::updatePlayerBattles(uint64_t id, uint32_t score, uint32_t wins)
+bool DbManager::insertPlayerBattlesBatch(std::vector<PlayerRecord>& refVecRecords)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+	TRACE_SPAN("DbManager::insertPlayerBattlesBatch");   // waiting for the shard writers included
+    if (refVecRecords.empty())
+    {
+        return true;
+    }
+    if (m_vecShards.empty())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Database not open."
+            << std::endl;
+        return false;
+    }
+
+	// assign ids and split the rows by shard
+    const uint64_t firstId = m_nextPlayerId.fetch_add(refVecRecords.size());
+    std::vector<std::vector<PlayerRecord>> vecShardRecords(m_vecShards.size());
+    for (size_t i = 0; i < refVecRecords.size(); i++)
+    {
+        refVecRecords[i].m_id = firstId + i;
+        vecShardRecords[_getShardIndex(refVecRecords[i].m_id)].emplace_back(refVecRecords[i]);
+    }
+
+	// every shard inserts its part in parallel on the executor
+    std::vector<std::future<bool>> vecResults;
+    for (size_t i = 0; i < vecShardRecords.size(); i++)
+    {
+        if (vecShardRecords[i].empty())
+        {
+            continue;
+        }
+        auto pPromise = std::make_shared<std::promise<bool>>();
+        vecResults.emplace_back(pPromise->get_future());
+        const std::vector<PlayerRecord>& refShardRecords = vecShardRecords[i];
+        _postWriteTask(*m_vecShards[i], [pPromise, &refShardRecords](sqlite3* pHandler)
+            {
+                pPromise->set_value(insertPlayerBattlesOn(pHandler, refShardRecords));
+            });
+    }
+    bool isOk = true;
+    for (auto& result : vecResults)
+    {
+        isOk = result.get() && isOk;
+    }
+    return isOk;
+}
 
-    if (!m_dbHandler)
+bool DbManager::updatePlayerBattles(uint64_t id, uint32_t score, uint32_t wins)
+{
+    TRACE_SPAN("DbManager::updatePlayerBattles");
+    if (m_vecShards.empty())
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
@@ -307,22 +943,25 @@ bool DbManager::updatePlayerBattles(uint64_t id, uint32_t score, uint32_t wins)
             << std::endl;
         return false;
     }
+    DbShard& refShard = *m_vecShards[_getShardIndex(id)];
+    std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
 
     const char* sql = "UPDATE player_battles SET score = ?, wins = ?, updated_time = ? WHERE id = ?;";
 
     sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(m_dbHandler, sql, -1, &stmt, nullptr);
+    int rc = sqlite3_prepare_v2(refShard.m_dbHandler, sql, -1, &stmt, nullptr);
 
     if (rc != SQLITE_OK)
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(refShard.m_dbHandler)
             << std::endl;
         return false;
     }
 
+	// exact wall clock like the snapshot time, the coarse or virtual ClockManager time would misplace the row against it
     const uint64_t updatedTime = time_utils::getTimestampMS();
 
     sqlite3_bind_int(stmt, 1, score);
@@ -338,18 +977,105 @@ bool DbManager::updatePlayerBattles(uint64_t id, uint32_t score, uint32_t wins)
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(refShard.m_dbHandler)
             << std::endl;
         return false;
     }
 
     return true;
 }
-bool DbManager::queryPlayerBattles(uint64_t id, uint32_t& score, uint32_t& wins, uint64_t& updateTime)
+
+// update the dirty fields of players in one transaction on the given connection
+static bool updatePlayerBattlesOn(sqlite3* pHandler, const std::vector<PlayerRecordUpdate>& refVecUpdates, uint64_t updatedTime)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    TRACE_SPAN("db.updatePlayerBattlesOn");
+    if (!pHandler)
+    {
+        return false;
+    }
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(pHandler, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << errMsg
+            << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+	// one statement for each combination of dirty fields, prepared on first use
+    const char* arrSql[common::PlayerDirtyField::DirtyPersisted + 1] = {
+        nullptr,
+        "UPDATE player_battles SET score = ?, updated_time = ? WHERE id = ?;",
+        "UPDATE player_battles SET wins = ?, updated_time = ? WHERE id = ?;",
+        "UPDATE player_battles SET score = ?, wins = ?, updated_time = ? WHERE id = ?;",
+    };
+    sqlite3_stmt* arrStmt[common::PlayerDirtyField::DirtyPersisted + 1] = { nullptr, nullptr, nullptr, nullptr };
 
-    if (!m_dbHandler)
+    bool isOk = true;
+    for (const auto& update : refVecUpdates)
+    {
+        const uint8_t dirtyMask = (update.m_dirtyMask & common::PlayerDirtyField::DirtyPersisted);
+        if (dirtyMask == common::PlayerDirtyField::DirtyNone)
+        {
+            continue;
+        }
+        sqlite3_stmt*& stmt = arrStmt[dirtyMask];
+        if (!stmt && sqlite3_prepare_v2(pHandler, arrSql[dirtyMask], -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(pHandler)
+                << std::endl;
+            isOk = false;
+            break;
+        }
+        int bindIndex = 1;
+        if (dirtyMask & common::PlayerDirtyField::DirtyScore)
+        {
+            sqlite3_bind_int(stmt, bindIndex++, update.m_record.m_score);
+        }
+        if (dirtyMask & common::PlayerDirtyField::DirtyWins)
+        {
+            sqlite3_bind_int(stmt, bindIndex++, update.m_record.m_wins);
+        }
+        sqlite3_bind_int64(stmt, bindIndex++, updatedTime);
+        sqlite3_bind_int64(stmt, bindIndex++, update.m_record.m_id);
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(pHandler)
+                << std::endl;
+            isOk = false;
+            break;
+        }
+    }
+    for (sqlite3_stmt* stmt : arrStmt)
+    {
+		sqlite3_finalize(stmt); // clean up the statement (no-op for nullptr)
+    }
+
+    rc = sqlite3_exec(pHandler, isOk ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+    return isOk && (rc == SQLITE_OK);
+}
+
+// split the updates by shard, every shard commits its part in parallel
+bool DbManager::updatePlayerBattlesBatch(const std::vector<PlayerRecordUpdate>& refVecUpdates)
+{
+	TRACE_SPAN("DbManager::updatePlayerBattlesBatch");   // waiting for the shard writers included
+    if (refVecUpdates.empty())
+    {
+        return true;
+    }
+    if (m_vecShards.empty())
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
@@ -359,17 +1085,144 @@ bool DbManager::queryPlayerBattles(uint64_t id, uint32_t& score, uint32_t& wins,
         return false;
     }
 
+    const auto beginTime = std::chrono::steady_clock::now();
+    std::vector<std::vector<PlayerRecordUpdate>> vecShardUpdates(m_vecShards.size());
+    for (const auto& update : refVecUpdates)
+    {
+        vecShardUpdates[_getShardIndex(update.m_record.m_id)].emplace_back(update);
+    }
+
+	// exact wall clock like the snapshot time, see updatePlayerBattles
+    const uint64_t updatedTime = time_utils::getTimestampMS();
+    std::vector<std::future<bool>> vecResults;
+    for (size_t i = 0; i < vecShardUpdates.size(); i++)
+    {
+        if (vecShardUpdates[i].empty())
+        {
+            continue;
+        }
+        auto pPromise = std::make_shared<std::promise<bool>>();
+        vecResults.emplace_back(pPromise->get_future());
+        const std::vector<PlayerRecordUpdate>& refShardUpdates = vecShardUpdates[i];
+        _postWriteTask(*m_vecShards[i], [pPromise, &refShardUpdates, updatedTime](sqlite3* pHandler)
+            {
+                pPromise->set_value(updatePlayerBattlesOn(pHandler, refShardUpdates, updatedTime));
+            });
+    }
+	// a failed shard fails the whole batch, the players are saved again later (updates are idempotent)
+    bool isOk = true;
+    for (auto& result : vecResults)
+    {
+        isOk = result.get() && isOk;
+    }
+    m_flushHistogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - beginTime).count());
+    if (isOk)
+    {
+        m_flushedRows.add(refVecUpdates.size());
+    }
+    else
+    {
+        m_failedFlushes.add();
+    }
+    return isOk;
+}
+
+void DbManager::startWriters()
+{
+    for (auto& uShard : m_vecShards)
+    {
+        std::lock_guard<std::mutex> lock(uShard->m_writeMutex);
+        uShard->m_isWriterRunning = true;
+    }
+}
+
+void DbManager::stopWriters()
+{
+    for (auto& uShard : m_vecShards)
+    {
+        std::unique_lock<std::mutex> lock(uShard->m_writeMutex);
+        uShard->m_isWriterRunning = false;
+		// wait for the queued writes
+        uShard->m_cvWrite.wait(lock, [&uShard]() { return !uShard->m_isWriterDraining; });
+    }
+}
+
+void DbManager::_postWriteTask(DbShard& refShard, std::function<void(sqlite3*)> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(refShard.m_writeMutex);
+        if (refShard.m_isWriterRunning)
+        {
+            refShard.m_queWriteTasks.emplace_back(std::move(task));
+            if (refShard.m_isWriterDraining)
+            {
+				// the running drain job picks it up
+                return;
+            }
+			// a worker waiting for its own write would hold a worker the drain may need, so it writes inline
+            DbShard* pShard = &refShard;
+            if (!ExecutorManager::instance().isWorkerThread() && ExecutorManager::instance().submit([this, pShard]() { this->drainWriteTasks(pShard); }))
+            {
+                refShard.m_isWriterDraining = true;
+                return;
+            }
+			// run on the caller thread
+            task = std::move(refShard.m_queWriteTasks.back());
+            refShard.m_queWriteTasks.pop_back();
+        }
+    }
+	// no writer (not connected or released), run on the caller thread
+    std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+    task(refShard.m_dbHandler);
+}
+
+// executor job of a shard, runs the queued writes in order with the shard lock held
+void DbManager::drainWriteTasks(DbShard* pShard)
+{
+    while (true)
+    {
+        std::function<void(sqlite3*)> task;
+        {
+            std::lock_guard<std::mutex> lock(pShard->m_writeMutex);
+            if (pShard->m_queWriteTasks.empty())
+            {
+                pShard->m_isWriterDraining = false;
+                pShard->m_cvWrite.notify_all();
+                break;
+            }
+            task = std::move(pShard->m_queWriteTasks.front());
+            pShard->m_queWriteTasks.pop_front();
+        }
+        std::lock_guard<ProfiledMutex> lock(pShard->m_mutex);
+        task(pShard->m_dbHandler);
+    }
+}
+
+// connection of the shard which owns the player
+static sqlite3* getShardHandler(const std::vector<sqlite3*>& refVecHandlers, uint64_t playerId)
+{
+    return refVecHandlers.empty() ? nullptr : refVecHandlers[playerId % refVecHandlers.size()];
+}
+
+// query one player with a prepared statement on the given connection
+static bool queryPlayerBattlesOn(sqlite3* pHandler, uint64_t id, PlayerRecord& refRecord)
+{
+    TRACE_SPAN("db.queryPlayerBattlesOn");
+    if (!pHandler)
+    {
+        return false;
+    }
     const char* sql = "SELECT score, wins, updated_time FROM player_battles WHERE id = ?;";
 
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(m_dbHandler, sql, -1, &stmt, nullptr);
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v2(pHandler, sql, -1, &stmt, nullptr);
 
     if (rc != SQLITE_OK)
     {
         std::cerr << "[ERROR] "
             << "[" << __FILE__ << ":" << __LINE__ << "] "
             << "[" << __func__ << "] "
-            << "SQL error: " << sqlite3_errmsg(m_dbHandler)
+            << "SQL error: " << sqlite3_errmsg(pHandler)
             << std::endl;
         return false;
     }
@@ -378,13 +1231,594 @@ bool DbManager::queryPlayerBattles(uint64_t id, uint32_t& score, uint32_t& wins,
 
     rc = sqlite3_step(stmt);
 
-    if (rc == SQLITE_ROW)
+    const bool isFound = (rc == SQLITE_ROW);
+    if (isFound)
+    {
+        refRecord.m_id = id;
+        refRecord.m_score = sqlite3_column_int(stmt, 0);
+        refRecord.m_wins = sqlite3_column_int(stmt, 1);
+        refRecord.m_updatedTime = sqlite3_column_int64(stmt, 2);
+    }
+	sqlite3_finalize(stmt); // clean up the statement, found or not
+    return isFound;
+}
+
+// query players in chunks of "IN (...)" on the given connection
+static bool queryPlayerBattlesManyOn(sqlite3* pHandler, const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords)
+{
+    TRACE_SPAN("db.queryPlayerBattlesManyOn");
+    if (!pHandler)
+    {
+        return false;
+    }
+    for (size_t offset = 0; offset < refVecIds.size(); offset += QUERY_IN_MAX_IDS)
+    {
+        const size_t idCounts = std::min(QUERY_IN_MAX_IDS, refVecIds.size() - offset);
+        std::string sql = "SELECT id, score, wins, updated_time FROM player_battles WHERE id IN (";
+        for (size_t i = 0; i < idCounts; i++)
+        {
+            sql += (i == 0) ? "?" : ",?";
+        }
+        sql += ");";
+
+        sqlite3_stmt* stmt = nullptr;
+        int rc = sqlite3_prepare_v2(pHandler, sql.c_str(), -1, &stmt, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(pHandler)
+                << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < idCounts; i++)
+        {
+            sqlite3_bind_int64(stmt, static_cast<int>(i + 1), refVecIds[offset + i]);
+        }
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            PlayerRecord record;
+            record.m_id = sqlite3_column_int64(stmt, 0);
+            record.m_score = sqlite3_column_int(stmt, 1);
+            record.m_wins = sqlite3_column_int(stmt, 2);
+            record.m_updatedTime = sqlite3_column_int64(stmt, 3);
+            refVecRecords.emplace_back(record);
+        }
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(pHandler)
+                << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// split the ids by shard and query every shard
+static bool queryPlayerBattlesManyOnShards(const std::vector<sqlite3*>& refVecHandlers, const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords)
+{
+    if (refVecHandlers.empty())
+    {
+        return false;
+    }
+    std::vector<std::vector<uint64_t>> vecShardIds(refVecHandlers.size());
+    for (uint64_t id : refVecIds)
+    {
+        vecShardIds[id % refVecHandlers.size()].emplace_back(id);
+    }
+    bool isOk = true;
+    for (size_t i = 0; i < vecShardIds.size(); i++)
+    {
+        if (!vecShardIds[i].empty())
+        {
+            isOk = queryPlayerBattlesManyOn(refVecHandlers[i], vecShardIds[i], refVecRecords) && isOk;
+        }
+    }
+    return isOk;
+}
+
+// blocks the caller, but the query itself runs on a reader connection without the shard lock
+bool DbManager::queryPlayerBattles(uint64_t id, uint32_t& score, uint32_t& wins, uint64_t& updateTime)
+{
+    const std::optional<PlayerRecord> record = queryPlayerBattlesAsync(id).get();
+    if (!record)
+    {
+        return false;
+    }
+    score = record->m_score;
+    wins = record->m_wins;
+    updateTime = record->m_updatedTime;
+    return true;
+}
+
+bool DbManager::queryPlayerBattlesMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords)
+{
+    std::promise<bool> promise;
+    std::future<bool> future = promise.get_future();
+    _postReadTask([&refVecIds, &refVecRecords, &promise](const std::vector<sqlite3*>& refVecHandlers)
+        {
+            promise.set_value(queryPlayerBattlesManyOnShards(refVecHandlers, refVecIds, refVecRecords));
+        });
+    return future.get();
+}
+
+std::future<std::optional<PlayerRecord>> DbManager::queryPlayerBattlesAsync(uint64_t id)
+{
+    auto pPromise = std::make_shared<std::promise<std::optional<PlayerRecord>>>();
+    std::future<std::optional<PlayerRecord>> future = pPromise->get_future();
+    _postReadTask([id, pPromise](const std::vector<sqlite3*>& refVecHandlers)
+        {
+            PlayerRecord record;
+            if (queryPlayerBattlesOn(getShardHandler(refVecHandlers, id), id, record))
+            {
+                pPromise->set_value(record);
+            }
+            else
+            {
+                pPromise->set_value(std::nullopt);
+            }
+        });
+    return future;
+}
+
+void DbManager::queryPlayerBattlesAsync(uint64_t id, std::function<void(bool isFound, const PlayerRecord& refRecord)> callback)
+{
+    _postReadTask([id, callback = std::move(callback)](const std::vector<sqlite3*>& refVecHandlers)
+        {
+            PlayerRecord record;
+            const bool isFound = queryPlayerBattlesOn(getShardHandler(refVecHandlers, id), id, record);
+            if (callback)
+            {
+                callback(isFound, record);
+            }
+        });
+}
+
+std::future<std::vector<PlayerRecord>> DbManager::queryPlayerBattlesManyAsync(std::vector<uint64_t> vecIds)
+{
+    auto pPromise = std::make_shared<std::promise<std::vector<PlayerRecord>>>();
+    std::future<std::vector<PlayerRecord>> future = pPromise->get_future();
+    _postReadTask([vecIds = std::move(vecIds), pPromise](const std::vector<sqlite3*>& refVecHandlers)
+        {
+            std::vector<PlayerRecord> vecRecords;
+            queryPlayerBattlesManyOnShards(refVecHandlers, vecIds, vecRecords);
+            pPromise->set_value(std::move(vecRecords));
+        });
+    return future;
+}
+
+void DbManager::startReaders(uint32_t readerCounts)
+{
+    std::lock_guard<std::mutex> lock(m_readMutex);
+    if (m_isReaderRunning)
+    {
+        return;
+    }
+    m_isReaderRunning = true;
+    for (uint32_t i = 0; i < readerCounts; i++)
+    {
+        m_vecReaderThreads.emplace_back(&DbManager::readerLoop, this);
+    }
+}
+
+void DbManager::stopReaders()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        m_isReaderRunning = false;
+    }
+    m_cvRead.notify_all();
+    for (auto& reader : m_vecReaderThreads)
+    {
+        if (reader.joinable())
+        {
+            reader.join();
+        }
+    }
+    m_vecReaderThreads.clear();
+}
+
+void DbManager::_postReadTask(std::function<void(const std::vector<sqlite3*>&)> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        if (m_isReaderRunning)
+        {
+            m_queReadTasks.emplace_back(std::move(task));
+            m_cvRead.notify_one();
+            return;
+        }
+    }
+	// no readers (not connected or released), complete the task as failed on the caller thread
+    task(std::vector<sqlite3*>());
+}
+
+// handler for the reader threads
+void DbManager::readerLoop()
+{
+    TraceManager::setThreadName("db reader");
+	// one read-only connection per shard, indexed like m_vecShards
+    std::vector<sqlite3*> vecReadHandlers;
+    for (auto& uShard : m_vecShards)
+    {
+        sqlite3* pReadHandler = nullptr;
+        if (sqlite3_open_v2(uShard->m_fileName.c_str(), &pReadHandler, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "SQL error: " << sqlite3_errmsg(pReadHandler)
+                << std::endl;
+            sqlite3_close(pReadHandler);
+			pReadHandler = nullptr; // tasks on this shard still run and complete as failed
+        }
+        else
+        {
+            sqlite3_busy_timeout(pReadHandler, DB_READER_BUSY_TIMEOUT_MS);
+        }
+        vecReadHandlers.emplace_back(pReadHandler);
+    }
+
+    while (true)
+    {
+        std::function<void(const std::vector<sqlite3*>&)> task;
+        {
+            std::unique_lock<std::mutex> lock(m_readMutex);
+            m_cvRead.wait(lock, [this]() { return !m_queReadTasks.empty() || !m_isReaderRunning; });
+            if (m_queReadTasks.empty())
+            {
+				// stopped and nothing left to read
+                break;
+            }
+            task = std::move(m_queReadTasks.front());
+            m_queReadTasks.pop_front();
+        }
+        task(vecReadHandlers);
+    }
+
+    for (sqlite3* pReadHandler : vecReadHandlers)
+    {
+        if (pReadHandler)
+        {
+            sqlite3_close(pReadHandler);
+        }
+    }
+}
+
+uint64_t DbManager::queryMaxBattleHistoryId()
+{
+    DbShard* pMainShard = _getMainShard();
+    if (!pMainShard)
+    {
+        return 0;
+    }
+    std::lock_guard<ProfiledMutex> lock(pMainShard->m_mutex);
+
+    const char* sql = "SELECT MAX(id) FROM battle_history;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(pMainShard->m_dbHandler, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pMainShard->m_dbHandler)
+            << std::endl;
+        return 0;
+    }
+    uint64_t maxId = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        maxId = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return maxId;
+}
+
+// insert battles and their members with multi-row inserts in one transaction
+bool DbManager::insertBattleHistoryBatch(const std::vector<BattleHistoryRecord>& refVecRecords)
+{
+    TRACE_SPAN("DbManager::insertBattleHistoryBatch");
+    if (refVecRecords.empty())
     {
-        score = sqlite3_column_int(stmt, 0);
-        wins = sqlite3_column_int(stmt, 1);
-        updateTime = sqlite3_column_int64(stmt, 2);
-		sqlite3_finalize(stmt); // clean up the statement
         return true;
     }
-    return false;
-}
\ No newline at end of file
+
+	// flatten members, so both tables are written in full chunks
+    std::vector<std::pair<const BattleHistoryRecord*, const BattleHistoryMember*>> vecMembers;
+    for (const auto& record : refVecRecords)
+    {
+        for (const auto& member : record.m_vecMembers)
+        {
+            vecMembers.emplace_back(&record, &member);
+        }
+    }
+
+    DbShard* pMainShard = _getMainShard();
+    if (!pMainShard)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Database not open."
+            << std::endl;
+        return false;
+    }
+    std::lock_guard<ProfiledMutex> lock(pMainShard->m_mutex);
+    sqlite3* pHandler = pMainShard->m_dbHandler;
+
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(pHandler, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << errMsg
+            << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    bool isOk = true;
+
+	// battle_history
+    for (size_t offset = 0; isOk && offset < refVecRecords.size(); offset += MULTI_ROW_INSERT_MAX_ROWS)
+    {
+        const size_t rowCounts = std::min(MULTI_ROW_INSERT_MAX_ROWS, refVecRecords.size() - offset);
+        const std::string sql = buildMultiRowInsertSql("battle_history", "id, room_id, battle_time, tier, red_team, blue_team, winner", 7, rowCounts);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(pHandler, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            isOk = false;
+            break;
+        }
+        int bindIndex = 1;
+        for (size_t i = offset; i < offset + rowCounts; i++)
+        {
+            const BattleHistoryRecord& record = refVecRecords[i];
+            std::string arrTeams[battle::TeamColor::TeamColorMax];
+            for (const auto& member : record.m_vecMembers)
+            {
+                if (member.m_team >= battle::TeamColor::TeamColorMax)
+                {
+                    continue;
+                }
+                std::string& refTeam = arrTeams[member.m_team];
+                refTeam += (refTeam.empty() ? "" : ",") + std::to_string(member.m_playerId);
+            }
+            sqlite3_bind_int64(stmt, bindIndex++, record.m_battleId);
+            sqlite3_bind_int64(stmt, bindIndex++, record.m_roomId);
+            sqlite3_bind_int64(stmt, bindIndex++, record.m_battleTime);
+            sqlite3_bind_int(stmt, bindIndex++, record.m_tier);
+            sqlite3_bind_text(stmt, bindIndex++, arrTeams[battle::TeamColor::TeamColorRed].c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, bindIndex++, arrTeams[battle::TeamColor::TeamColorBlue].c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, bindIndex++, record.m_winner);
+        }
+        isOk = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_finalize(stmt);
+    }
+
+	// battle_history_players
+    for (size_t offset = 0; isOk && offset < vecMembers.size(); offset += MULTI_ROW_INSERT_MAX_ROWS)
+    {
+        const size_t rowCounts = std::min(MULTI_ROW_INSERT_MAX_ROWS, vecMembers.size() - offset);
+        const std::string sql = buildMultiRowInsertSql("battle_history_players", "player_id, battle_time, battle_id, team, score_delta", 5, rowCounts);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(pHandler, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            isOk = false;
+            break;
+        }
+        int bindIndex = 1;
+        for (size_t i = offset; i < offset + rowCounts; i++)
+        {
+            const BattleHistoryRecord* pRecord = vecMembers[i].first;
+            const BattleHistoryMember* pMember = vecMembers[i].second;
+            sqlite3_bind_int64(stmt, bindIndex++, pMember->m_playerId);
+            sqlite3_bind_int64(stmt, bindIndex++, pRecord->m_battleTime);
+            sqlite3_bind_int64(stmt, bindIndex++, pRecord->m_battleId);
+            sqlite3_bind_int(stmt, bindIndex++, pMember->m_team);
+            sqlite3_bind_int(stmt, bindIndex++, pMember->m_scoreDelta);
+        }
+        isOk = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_finalize(stmt);
+    }
+
+    if (!isOk)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pHandler)
+            << std::endl;
+    }
+    rc = sqlite3_exec(pHandler, isOk ? "COMMIT;" : "ROLLBACK;", nullptr, nullptr, nullptr);
+    return isOk && (rc == SQLITE_OK);
+}
+
+// latest battles of a player, newest first
+bool DbManager::queryPlayerBattleHistory(uint64_t playerId, uint32_t limit, std::vector<PlayerBattleHistory>& refVecHistory)
+{
+    TRACE_SPAN("DbManager::queryPlayerBattleHistory");
+    refVecHistory.clear();
+
+    DbShard* pMainShard = _getMainShard();
+    if (!pMainShard)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Database not open."
+            << std::endl;
+        return false;
+    }
+    std::lock_guard<ProfiledMutex> lock(pMainShard->m_mutex);
+    sqlite3* pHandler = pMainShard->m_dbHandler;
+
+    const char* sql =
+        "SELECT h.id, h.room_id, h.battle_time, h.tier, h.red_team, h.blue_team, h.winner, p.team, p.score_delta "
+        "FROM battle_history_players p JOIN battle_history h ON h.id = p.battle_id "
+        "WHERE p.player_id = ? ORDER BY p.battle_time DESC, p.battle_id DESC LIMIT ?;";
+    sqlite3_stmt* stmt = nullptr;
+    int rc = sqlite3_prepare_v2(pHandler, sql, -1, &stmt, nullptr);
+    if (rc != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pHandler)
+            << std::endl;
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, playerId);
+    sqlite3_bind_int(stmt, 2, limit);
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        PlayerBattleHistory history;
+        history.m_battleId = sqlite3_column_int64(stmt, 0);
+        history.m_roomId = sqlite3_column_int64(stmt, 1);
+        history.m_battleTime = sqlite3_column_int64(stmt, 2);
+        history.m_tier = sqlite3_column_int(stmt, 3);
+        const unsigned char* pRedTeam = sqlite3_column_text(stmt, 4);
+        const unsigned char* pBlueTeam = sqlite3_column_text(stmt, 5);
+        history.m_redTeam = pRedTeam ? reinterpret_cast<const char*>(pRedTeam) : "";
+        history.m_blueTeam = pBlueTeam ? reinterpret_cast<const char*>(pBlueTeam) : "";
+        history.m_winner = static_cast<uint8_t>(sqlite3_column_int(stmt, 6));
+        history.m_team = static_cast<uint8_t>(sqlite3_column_int(stmt, 7));
+        history.m_scoreDelta = sqlite3_column_int(stmt, 8);
+        refVecHistory.emplace_back(history);
+    }
+	sqlite3_finalize(stmt); // clean up the statement
+    return (rc == SQLITE_DONE);
+}
+
+bool DbManager::startBackup()
+{
+    if (m_vecShards.empty())
+    {
+        return false;
+    }
+    if (m_isBackupRunning.exchange(true))
+    {
+        std::cerr << "[WARNING] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Backup is already running."
+            << std::endl;
+        return false;
+    }
+    if (m_backupThread.joinable())
+    {
+		// the previous backup has finished
+        m_backupThread.join();
+    }
+    m_backupThread = std::thread(&DbManager::backupLoop, this);
+    return true;
+}
+
+// back up the shards one by one
+void DbManager::backupLoop()
+{
+    const auto beginTime = std::chrono::steady_clock::now();
+
+    int64_t totalPages = 0;
+    for (auto& uShard : m_vecShards)
+    {
+        const int pages = _backupShard(*uShard, _getBackupFileName(uShard->m_index));
+        if (pages < 0)
+        {
+            m_isBackupRunning = false;
+            return;
+        }
+        totalPages += pages;
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    const int64_t pagesPerSec = (elapsedMs > 0) ? (totalPages * 1000 / elapsedMs) : totalPages;
+    std::cout << "[DbManager] : backup of " << m_vecShards.size() << " shards done, " << totalPages << " pages in "
+        << elapsedMs << " ms (" << pagesPerSec << " pages/sec)." << std::endl;
+    m_isBackupRunning = false;
+}
+
+// copy the shard page by page with the sqlite online backup API
+// writes made through the shard connection during the backup are applied to the copy by sqlite, so the backup never restarts
+int DbManager::_backupShard(DbShard& refShard, const std::string& backupFileName)
+{
+    TRACE_SPAN("DbManager::backupShard");
+    const auto beginTime = std::chrono::steady_clock::now();
+    const std::string tmpFileName = backupFileName + ".tmp";
+    std::remove(tmpFileName.c_str());
+
+    sqlite3* pBackupHandler = nullptr;
+    if (sqlite3_open(tmpFileName.c_str(), &pBackupHandler) != SQLITE_OK)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pBackupHandler)
+            << std::endl;
+        sqlite3_close(pBackupHandler);
+        return -1;
+    }
+
+    sqlite3_backup* pBackup = nullptr;
+    {
+        std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+        if (refShard.m_dbHandler)
+        {
+            pBackup = sqlite3_backup_init(pBackupHandler, "main", refShard.m_dbHandler, "main");
+        }
+    }
+    if (!pBackup)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "SQL error: " << sqlite3_errmsg(pBackupHandler)
+            << std::endl;
+        sqlite3_close(pBackupHandler);
+        std::remove(tmpFileName.c_str());
+        return -1;
+    }
+
+    int rc = SQLITE_OK;
+    int totalPages = 0;
+    while (!m_isBackupCanceled)
+    {
+        {
+            std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+            rc = sqlite3_backup_step(pBackup, BACKUP_STEP_PAGES);
+            totalPages = sqlite3_backup_pagecount(pBackup);
+        }
+        if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED)
+        {
+            break;
+        }
+		std::this_thread::sleep_for(BACKUP_STEP_YIELD);    // yield to the writers
+    }
+    {
+        std::lock_guard<ProfiledMutex> lock(refShard.m_mutex);
+        sqlite3_backup_finish(pBackup);
+    }
+    sqlite3_close(pBackupHandler);
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    if (rc != SQLITE_DONE || !file_utils::replaceFile(tmpFileName, backupFileName))
+    {
+        std::cerr << (m_isBackupCanceled ? "[WARNING] " : "[ERROR] ")
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << (m_isBackupCanceled ? "Backup canceled" : "Backup failed") << " for " << refShard.m_fileName << " after " << elapsedMs << " ms (rc : " << rc << ")."
+            << std::endl;
+        std::remove(tmpFileName.c_str());
+        return -1;
+    }
+    std::cout << "[DbManager] : backup " << backupFileName << " done, " << totalPages << " pages in " << elapsedMs << " ms." << std::endl;
+    return totalPages;
+}
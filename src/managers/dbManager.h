@@ -8,27 +8,75 @@
 #include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <future>
+#include <optional>
+#include <atomic>
+#include <cstdint>
+#include "../../utils/histogram.h"
+#include "../../utils/counter.h"
+#include "../../utils/profiledMutex.h"
 
 struct sqlite3;
+class Player;
+struct PlayerRecord;
+struct PlayerRecordUpdate;
+struct BattleHistoryRecord;
+struct PlayerBattleHistory;
 
 class DbManager
 {
 public:
     static DbManager& instance();
 
+	// database file and shard counts, must be called before connect
+	// player_battles is split by player id over the shards, the other tables only live in shard 0 (the main file)
+    void configure(const std::string& dbName, uint32_t shardCounts);
+    uint32_t getShardCounts() const { return m_shardCounts; }
+
     bool initialize();
     bool connect();
     void release();
-    void loadTableData();
+    bool loadTableData();
     bool ensureTableSchema();
-    bool isTableExists(const std::string tableName);
-    bool createTable(const std::string tableName);
+    bool isTableExists(uint32_t shardIndex, const std::string tableName);
+    bool createTable(uint32_t shardIndex, const std::string tableName);
+    bool createIndexes(uint32_t shardIndex);
 
-    void syncAllPlayerBattles();
-    uint64_t insertPlayerBattles();
+    bool loadPlayerBattles();
+    bool syncAllPlayerBattles();
+    bool syncPlayerBattlesSince(uint64_t updatedTime);
+    bool loadPlayerBattlesRange(const std::string& fileName, uint64_t minId, uint64_t maxId, std::vector<std::unique_ptr<Player>>& refVecPartition);
+    uint64_t insertPlayerBattles(uint32_t score, uint32_t wins, uint64_t updatedTime);
+	// insert new players with ids assigned here, each shard writes its part in parallel
+    bool insertPlayerBattlesBatch(std::vector<PlayerRecord>& refVecRecords);
     bool updatePlayerBattles(uint64_t id, uint32_t score, uint32_t wins);
+	// update the dirty fields of players, each shard writes its part in parallel
+    bool updatePlayerBattlesBatch(const std::vector<PlayerRecordUpdate>& refVecUpdates);
     bool queryPlayerBattles(uint64_t id, uint32_t& score, uint32_t& wins, uint64_t& updateTime);
+	// load the found players of vecIds with "IN" queries, missing ids are skipped
+    bool queryPlayerBattlesMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords);
+
+	// async queries run on the reader threads with their own read-only connections and never take a shard lock
+	// *** callbacks are called on a reader thread ***
+    std::future<std::optional<PlayerRecord>> queryPlayerBattlesAsync(uint64_t id);
+    void queryPlayerBattlesAsync(uint64_t id, std::function<void(bool isFound, const PlayerRecord& refRecord)> callback);
+    std::future<std::vector<PlayerRecord>> queryPlayerBattlesManyAsync(std::vector<uint64_t> vecIds);
+
+    uint64_t queryMaxBattleHistoryId();
+    bool insertBattleHistoryBatch(const std::vector<BattleHistoryRecord>& refVecRecords);
+    bool queryPlayerBattleHistory(uint64_t playerId, uint32_t limit, std::vector<PlayerBattleHistory>& refVecHistory);
 
+	// online backup of every shard on a background thread, false if db is not open or a backup is running
+    bool startBackup();
+    bool isBackupRunning() const { return m_isBackupRunning.load(); }
+
+	// player_battles flushes (updatePlayerBattlesBatch), read without the shard locks (metrics)
+    const LatencyHistogram& getFlushHistogram() const { return m_flushHistogram; }
+    uint64_t getFlushedRows() const { return m_flushedRows.get(); }
+    uint64_t getFailedFlushes() const { return m_failedFlushes.get(); }
 
 private:
     DbManager();
@@ -39,11 +87,69 @@ private:
     DbManager(DbManager&&) = delete;
     DbManager& operator=(DbManager&&) = delete;
 
-    sqlite3* m_dbHandler = nullptr;
+	// one database file with its connection and write queue
+    struct DbShard
+    {
+        uint32_t m_index = 0;
+        std::string m_fileName = "";
+        sqlite3* m_dbHandler = nullptr;
+		ProfiledMutex m_mutex{ "DbShard::m_mutex" };             // lock for m_dbHandler, shared by the shards in the lock statistics
+
+        std::deque<std::function<void(sqlite3*)>> m_queWriteTasks{};
+		std::mutex m_writeMutex;                                // lock for m_queWriteTasks, m_isWriterRunning, m_isWriterDraining
+		std::condition_variable m_cvWrite;                      // stopWriters waits for the drain to finish
+		bool m_isWriterRunning = false;                         // write tasks are queued (otherwise run on the caller)
+		bool m_isWriterDraining = false;                        // an executor job is draining the queue, at most one per shard
+    };
+
+	// shard of a player, hashed so that sequential ids spread over all shards
+    uint32_t _getShardIndex(uint64_t playerId) const { return static_cast<uint32_t>(playerId % m_vecShards.size()); }
+    DbShard* _getMainShard() { return m_vecShards.empty() ? nullptr : m_vecShards[0].get(); }
+    std::string _getShardFileName(uint32_t shardIndex) const;
+    std::string _getBackupFileName(uint32_t shardIndex) const;
+	// the shard counts of existing data must match the configured shard counts
+    bool _checkShardCounts();
+    void _closeShards();
+    uint64_t _queryMaxPlayerId();
+
+	// shard writers, the write queue of a shard is drained by one ExecutorManager job at a time (in order)
+    void startWriters();
+    void stopWriters();
+    void drainWriteTasks(DbShard* pShard);
+	// run a write task on the executor with the shard lock held
+    void _postWriteTask(DbShard& refShard, std::function<void(sqlite3*)> task);
+
+	// reader threads
+    void startReaders(uint32_t readerCounts);
+    void stopReaders();
+    void readerLoop();
+	// run a read task on a reader thread with one read-only connection per shard (nullptr if not running)
+    void _postReadTask(std::function<void(const std::vector<sqlite3*>&)> task);
+
+	// handler for the backup thread
+    void backupLoop();
+	// back up one shard, returns the pages copied (-1 if failed)
+    int _backupShard(DbShard& refShard, const std::string& backupFileName);
+
     std::string m_dbName = "";
-    std::unordered_map<std::string/* table name */, std::function<void()>> m_mapFuncSyncData{};
+	uint32_t m_shardCounts = 1;                                 // configured shard counts
+    std::vector<std::unique_ptr<DbShard>> m_vecShards{};        // opened shards, shard 0 is the main file
+	std::atomic<uint64_t> m_nextPlayerId = 1;                   // player ids are assigned here to route inserts
+    std::unordered_map<std::string/* table name */, std::function<bool()>> m_mapFuncSyncData{};
+
+    std::deque<std::function<void(const std::vector<sqlite3*>&)>> m_queReadTasks{};    // read tasks waiting for a reader
+	std::vector<std::thread> m_vecReaderThreads{};              // reader threads
+	std::mutex m_readMutex;                                     // lock for m_queReadTasks, m_isReaderRunning
+	std::condition_variable m_cvRead;                           // wake up the readers
+	bool m_isReaderRunning = false;                             // reader threads control flag
+
+	std::thread m_backupThread;                                 // background backup thread
+	std::atomic<bool> m_isBackupRunning = false;                // a backup is in progress
+	std::atomic<bool> m_isBackupCanceled = false;               // stop the backup on release
 
-	std::mutex m_mutex; // lock for thread safety
+	LatencyHistogram m_flushHistogram;                          // duration of updatePlayerBattlesBatch (us)
+	ShardedCounter m_flushedRows;                               // rows written by successful flushes
+	ShardedCounter m_failedFlushes;
 };
 
-#endif // DB_MANAGER_H
\ No newline at end of file
+#endif // DB_MANAGER_H
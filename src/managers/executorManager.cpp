@@ -0,0 +1,225 @@
+// @file  : executorManager.cpp
+// @brief : shared work-stealing task executor
+// @author: August
+// @date  : 2025-06-13
+#include "executorManager.h"
+#include "clockManager.h"
+#include "traceManager.h"
+#include <iostream>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// index of the current worker in its executor, -1 for other threads
+static thread_local int32_t t_workerIndex = -1;
+
+ExecutorManager& ExecutorManager::instance()
+{
+    static ExecutorManager instance;
+    return instance;
+}
+
+ExecutorManager::ExecutorManager()
+{
+}
+
+ExecutorManager::~ExecutorManager()
+{
+}
+
+bool ExecutorManager::initialize(uint32_t threadCounts, bool isPinThreads)
+{
+    if (m_running)
+    {
+        return true;
+    }
+    if (threadCounts == 0)
+    {
+        threadCounts = std::max<uint32_t>(2, std::thread::hardware_concurrency());
+    }
+    m_pendingTasks = 0;
+    m_executedTasks = 0;
+    m_stolenTasks = 0;
+    m_vecWorkers.clear();
+    for (uint32_t i = 0; i < threadCounts; i++)
+    {
+        m_vecWorkers.emplace_back(std::make_unique<Worker>());
+    }
+
+	// start after all deques exist, workers steal from each other
+    m_running = true;
+    const uint32_t cpuCounts = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+    for (uint32_t i = 0; i < threadCounts; i++)
+    {
+        m_vecWorkers[i]->m_thread = std::thread(&ExecutorManager::workerLoop, this, i);
+        if (isPinThreads)
+        {
+            _pinThread(m_vecWorkers[i]->m_thread, i % cpuCounts);
+        }
+    }
+
+    std::cout << "[ExecutorManager] : initialized! (" << threadCounts << " workers" << (isPinThreads ? ", pinned" : "") << ")" << std::endl;
+    return true;
+}
+
+void ExecutorManager::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running = false;
+    }
+    m_cvSleep.notify_all();
+    for (auto& uWorker : m_vecWorkers)
+    {
+        if (uWorker->m_thread.joinable())
+        {
+			// wait for the worker to run the remaining tasks
+            uWorker->m_thread.join();
+        }
+    }
+    m_vecWorkers.clear();
+    std::cout << "[ExecutorManager] : released! (" << m_executedTasks << " tasks, " << m_stolenTasks << " stolen)" << std::endl;
+}
+
+bool ExecutorManager::isWorkerThread() const
+{
+    return t_workerIndex >= 0;
+}
+
+bool ExecutorManager::submit(std::function<void()> task)
+{
+    if (!m_running || m_vecWorkers.empty())
+    {
+        return false;
+    }
+	ClockManager::instance().beginWork();   // virtual time stands still until the task has run
+
+	// a worker keeps its own tasks, other threads spread them
+    const uint32_t workerIndex = (t_workerIndex >= 0 && static_cast<size_t>(t_workerIndex) < m_vecWorkers.size())
+        ? static_cast<uint32_t>(t_workerIndex)
+        : (m_nextWorkerIndex.fetch_add(1, std::memory_order_relaxed) % m_vecWorkers.size());
+	// count before the push, a worker may run the task and decrement as soon as the deque is unlocked
+    m_unfinishedTasks.fetch_add(1);
+    m_pendingTasks.fetch_add(1);
+    {
+        Worker& refWorker = *m_vecWorkers[workerIndex];
+        std::lock_guard<std::mutex> lock(refWorker.m_mutex);
+        refWorker.m_deqTasks.emplace_back(std::move(task));
+    }
+
+	// take the sleep lock so a worker between its check and its wait does not miss the notify
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_cvSleep.notify_one();
+    return true;
+}
+
+bool ExecutorManager::waitIdle()
+{
+    if (isWorkerThread())
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    if (m_unfinishedTasks.load() == 0)
+    {
+        return true;
+    }
+	// tasks may be submitted again right after, so wait for the executor to run dry once instead of a zero count
+    const uint64_t idleGeneration = m_idleGeneration;
+    m_cvIdle.wait(lock, [this, idleGeneration]() { return m_idleGeneration != idleGeneration; });
+    return true;
+}
+
+bool ExecutorManager::_popTask(uint32_t workerIndex, std::function<void()>& refTask)
+{
+    {
+        Worker& refWorker = *m_vecWorkers[workerIndex];
+        std::lock_guard<std::mutex> lock(refWorker.m_mutex);
+        if (!refWorker.m_deqTasks.empty())
+        {
+            refTask = std::move(refWorker.m_deqTasks.back());
+            refWorker.m_deqTasks.pop_back();
+            return true;
+        }
+    }
+
+	// steal the oldest task of the next workers
+    const size_t workerCounts = m_vecWorkers.size();
+    for (size_t i = 1; i < workerCounts; i++)
+    {
+        Worker& refVictim = *m_vecWorkers[(workerIndex + i) % workerCounts];
+        std::lock_guard<std::mutex> lock(refVictim.m_mutex);
+        if (!refVictim.m_deqTasks.empty())
+        {
+            refTask = std::move(refVictim.m_deqTasks.front());
+            refVictim.m_deqTasks.pop_front();
+            m_stolenTasks.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// handler for the worker threads
+void ExecutorManager::workerLoop(uint32_t workerIndex)
+{
+    t_workerIndex = static_cast<int32_t>(workerIndex);
+    TraceManager::setThreadName("executor worker");
+
+    std::function<void()> task;
+    while (true)
+    {
+        if (_popTask(workerIndex, task))
+        {
+            m_pendingTasks.fetch_sub(1);
+            task();
+            task = nullptr;
+            m_executedTasks.fetch_add(1, std::memory_order_relaxed);
+            ClockManager::instance().endWork();
+            if (m_unfinishedTasks.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(m_idleMutex);
+                m_idleGeneration++;
+                m_cvIdle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_pendingTasks.load() > 0)
+        {
+			// a task was queued (or is being popped by another worker) after the deques were checked
+            continue;
+        }
+        if (!m_running)
+        {
+			// stopped and nothing left to run
+            break;
+        }
+        m_cvSleep.wait(lock, [this]() { return m_pendingTasks.load() > 0 || !m_running; });
+    }
+    t_workerIndex = -1;
+}
+
+void ExecutorManager::_pinThread(std::thread& refThread, uint32_t cpuIndex)
+{
+#ifdef _WIN32
+    SetThreadAffinityMask(refThread.native_handle(), static_cast<DWORD_PTR>(1) << (cpuIndex % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpuIndex, &cpuSet);
+    pthread_setaffinity_np(refThread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#else
+    (void)refThread;
+    (void)cpuIndex;
+#endif
+}
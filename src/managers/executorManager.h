@@ -0,0 +1,82 @@
+// executorManager.h
+#ifndef EXECUTOR_MANAGER_H
+#define EXECUTOR_MANAGER_H
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// process-wide task executor with a fixed number of worker threads
+// every worker owns a deque : tasks submitted by a worker go to the back of its own deque and are popped from the back (LIFO, cache-warm),
+// tasks submitted by other threads are spread round-robin, an idle worker steals from the front of the other deques
+// *** tasks must not block for long (sleep, wait on another task), use ScheduleManager for delays ***
+class ExecutorManager
+{
+public:
+    static ExecutorManager& instance();
+
+	// threadCounts : 0 for the hardware concurrency (at least 2)
+	// isPinThreads : pin worker i to cpu (i % cpu counts), ignored where not supported
+    bool initialize(uint32_t threadCounts = 0, bool isPinThreads = false);
+	// run the queued tasks and stop the workers
+    void release();
+
+	// queue a task, false if the executor is not running (the task is not run)
+    bool submit(std::function<void()> task);
+	// wait until no task is queued or running, every task submitted before the call (and the tasks they submit) has finished
+	// false if called on a worker (it would wait for itself)
+    bool waitIdle();
+
+    bool isRunning() const { return m_running.load(); }
+    uint32_t getThreadCounts() const { return static_cast<uint32_t>(m_vecWorkers.size()); }
+	// the calling thread is one of the workers
+    bool isWorkerThread() const;
+
+    uint64_t getExecutedTasks() const { return m_executedTasks.load(std::memory_order_relaxed); }
+    uint64_t getStolenTasks() const { return m_stolenTasks.load(std::memory_order_relaxed); }
+	// tasks queued and not yet started
+    uint64_t getPendingTasks() const { return m_pendingTasks.load(std::memory_order_relaxed); }
+
+private:
+    ExecutorManager();
+    ~ExecutorManager();
+
+    ExecutorManager(const ExecutorManager&) = delete;
+    ExecutorManager& operator=(const ExecutorManager&) = delete;
+    ExecutorManager(ExecutorManager&&) = delete;
+    ExecutorManager& operator=(ExecutorManager&&) = delete;
+
+    struct Worker
+    {
+        std::deque<std::function<void()>> m_deqTasks{};
+		std::mutex m_mutex;                 // lock for m_deqTasks
+		std::thread m_thread;
+    };
+
+    void workerLoop(uint32_t workerIndex);
+	// own deque first (back), then steal from the others (front)
+    bool _popTask(uint32_t workerIndex, std::function<void()>& refTask);
+    static void _pinThread(std::thread& refThread, uint32_t cpuIndex);
+
+    std::vector<std::unique_ptr<Worker>> m_vecWorkers{};
+	std::atomic<uint32_t> m_nextWorkerIndex = 0;    // round-robin target for submits from other threads
+	std::atomic<uint64_t> m_pendingTasks = 0;       // queued tasks over all deques
+	std::mutex m_sleepMutex;                        // lock for m_cvSleep
+	std::condition_variable m_cvSleep;              // wake up idle workers
+	std::atomic<bool> m_running = false;            // workers accept and run tasks
+	std::atomic<uint64_t> m_unfinishedTasks = 0;    // queued or running
+	std::mutex m_idleMutex;                         // lock for m_cvIdle, m_idleGeneration
+	std::condition_variable m_cvIdle;               // wake up waitIdle
+	uint64_t m_idleGeneration = 0;                  // times the executor ran out of tasks
+
+	std::atomic<uint64_t> m_executedTasks = 0;
+	std::atomic<uint64_t> m_stolenTasks = 0;
+};
+
+#endif // EXECUTOR_MANAGER_H
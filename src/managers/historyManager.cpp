@@ -0,0 +1,120 @@
+// @file  : historyManager.cpp
+// @brief : background writer of battle history
+// @author: August
+// @date  : 2025-06-09
+#include "historyManager.h"
+#include "dbManager.h"
+#include <iostream>
+#include <chrono>
+
+const size_t HISTORY_BATCH_SIZE = 500;                          // write when this many battles are pending
+const std::chrono::milliseconds HISTORY_FLUSH_INTERVAL(1000);   // or when the oldest pending battle waited this long
+
+HistoryManager& HistoryManager::instance()
+{
+    static HistoryManager instance;
+    return instance;
+}
+
+HistoryManager::HistoryManager()
+{
+}
+
+HistoryManager::~HistoryManager()
+{
+}
+
+bool HistoryManager::initialize()
+{
+    m_vecPendingRecords.clear();
+    m_nextBattleId = 1;
+    m_running = false;
+
+    std::cout << "[HistoryManager] : initialized!" << std::endl;
+    return true;
+}
+
+void HistoryManager::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cvPending.notify_all();
+    if (m_writerThread.joinable())
+    {
+		// wait for the writer to write the remaining battles
+        m_writerThread.join();
+    }
+    std::cout << "[HistoryManager] : released!" << std::endl;
+}
+
+bool HistoryManager::start()
+{
+    m_nextBattleId = DbManager::instance().queryMaxBattleHistoryId() + 1;
+    m_running = true;
+    m_writerThread = std::thread(&HistoryManager::writerLoop, this);
+    return true;
+}
+
+void HistoryManager::addBattle(BattleHistoryRecord&& record)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running)
+    {
+        return;
+    }
+    m_vecPendingRecords.emplace_back(std::move(record));
+    if (m_vecPendingRecords.size() >= HISTORY_BATCH_SIZE)
+    {
+        m_cvPending.notify_one();
+    }
+}
+
+bool HistoryManager::queryPlayerHistory(uint64_t playerId, uint32_t counts, std::vector<PlayerBattleHistory>& refVecHistory)
+{
+    if (!m_running)
+    {
+        return false;
+    }
+    return DbManager::instance().queryPlayerBattleHistory(playerId, counts, refVecHistory);
+}
+
+// handler for the writer thread, writes pending battles in batches
+void HistoryManager::writerLoop()
+{
+    std::vector<BattleHistoryRecord> vecBatch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvPending.wait_for(lock, HISTORY_FLUSH_INTERVAL, [this]()
+                {
+                    return (m_vecPendingRecords.size() >= HISTORY_BATCH_SIZE) || !m_running;
+                });
+            if (m_vecPendingRecords.empty())
+            {
+                if (!m_running)
+                {
+                    break;
+                }
+                continue;
+            }
+            vecBatch.swap(m_vecPendingRecords);
+        }
+
+        for (auto& record : vecBatch)
+        {
+            record.m_battleId = m_nextBattleId++;
+        }
+        if (!DbManager::instance().insertBattleHistoryBatch(vecBatch))
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Failed to write " << vecBatch.size() << " battle history records."
+                << std::endl;
+        }
+        vecBatch.clear();
+    }
+}
@@ -0,0 +1,83 @@
+// historyManager.h
+#ifndef HISTORY_MANAGER_H
+#define HISTORY_MANAGER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// one player in a finished battle
+struct BattleHistoryMember
+{
+	uint64_t m_playerId = 0;    // player ID
+	uint8_t m_team = 0;         // battle::TeamColor
+	int32_t m_scoreDelta = 0;   // score gained (positive) or lost (negative)
+};
+
+// one finished battle
+struct BattleHistoryRecord
+{
+	uint64_t m_battleId = 0;    // assigned by the writer
+	uint64_t m_roomId = 0;      // battle room ID (restarts from 1 on every launch)
+	uint64_t m_battleTime = 0;  // timestamp(ms) when the battle finished
+	uint32_t m_tier = 0;        // matched tier
+	uint8_t m_winner = 0;       // battle::TeamColor of the winning team
+    std::vector<BattleHistoryMember> m_vecMembers{};
+};
+
+// one row of a player's battle history query
+struct PlayerBattleHistory
+{
+    uint64_t m_battleId = 0;
+    uint64_t m_roomId = 0;
+    uint64_t m_battleTime = 0;
+    uint32_t m_tier = 0;
+    uint8_t m_winner = 0;
+    std::string m_redTeam = "";     // player ids joined by ','
+    std::string m_blueTeam = "";    // player ids joined by ','
+    uint8_t m_team = 0;             // team of the queried player
+    int32_t m_scoreDelta = 0;       // score delta of the queried player
+};
+
+class HistoryManager
+{
+public:
+    static HistoryManager& instance();
+
+    bool initialize();
+    void release();
+
+	// start the background writer, battle ids continue from the max id in db
+    bool start();
+
+	// queue a finished battle, dropped if the writer is not running
+    void addBattle(BattleHistoryRecord&& record);
+
+	// latest battles of a player (newest first), false if history is not recorded
+    bool queryPlayerHistory(uint64_t playerId, uint32_t counts, std::vector<PlayerBattleHistory>& refVecHistory);
+
+private:
+    HistoryManager();
+    ~HistoryManager();
+
+    HistoryManager(const HistoryManager&) = delete;
+    HistoryManager& operator=(const HistoryManager&) = delete;
+    HistoryManager(HistoryManager&&) = delete;
+    HistoryManager& operator=(HistoryManager&&) = delete;
+
+    void writerLoop();
+
+    std::vector<BattleHistoryRecord> m_vecPendingRecords{};   // battles waiting for the writer
+	std::mutex m_mutex;                                     // lock for m_vecPendingRecords
+	std::condition_variable m_cvPending;                    // wake up the writer
+
+	uint64_t m_nextBattleId = 1;                            // only used by the writer thread
+	std::thread m_writerThread;                             // background writer thread
+	std::atomic<bool> m_running = false;                    // thread control flag
+};
+
+#endif // HISTORY_MANAGER_H
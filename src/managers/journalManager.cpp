@@ -0,0 +1,448 @@
+// @file  : journalManager.cpp
+// @brief : append-only journal of battle results with group commit
+// @author: August
+// @date  : 2025-06-04
+#include "journalManager.h"
+#include "playerManager.h"
+#include "clockManager.h"
+#include "../../utils/utils.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cstddef>
+#include <chrono>
+
+const uint32_t JOURNAL_MAGIC = 0x4C4A4D47;  // "GMJL"
+const uint32_t JOURNAL_VERSION = 1;
+const int JOURNAL_WRITE_ATTEMPTS = 3;       // attempts of one batch, each retry in a new segment
+
+static_assert(sizeof(JournalRecord) == 40, "JournalRecord layout is part of the journal file format");
+static_assert(sizeof(JournalSegmentHeader) == 8, "JournalSegmentHeader layout is part of the journal file format");
+
+// FNV-1a of the record without the checksum fields, folded into 32 bits
+static uint32_t calcRecordChecksum(const JournalRecord& record)
+{
+    const uint8_t* pData = reinterpret_cast<const uint8_t*>(&record);
+    const size_t size = offsetof(JournalRecord, m_checksum);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= pData[i];
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+JournalManager& JournalManager::instance()
+{
+    static JournalManager instance;
+    return instance;
+}
+
+JournalManager::JournalManager()
+    : m_filePrefix("gameMatch.journal.")
+{
+}
+
+JournalManager::~JournalManager()
+{
+}
+
+bool JournalManager::initialize()
+{
+    m_vecPendingRecords.clear();
+    m_vecSegments.clear();
+    m_lastSeq = 0;
+    m_durableSeq = 0;
+    m_writtenSeq = 0;
+    m_failedSeq = 0;
+    m_running = false;
+
+    std::cout << "[JournalManager] : initialized!" << std::endl;
+    return true;
+}
+
+void JournalManager::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_running = false;
+    }
+    m_cvPending.notify_all();
+    if (m_writerThread.joinable())
+    {
+		// wait for the writer to write the remaining records
+        m_writerThread.join();
+    }
+    m_cvDurable.notify_all();
+
+	// the writer completed the callbacks it could, the rest belong to records it failed to write
+    std::vector<std::pair<bool, std::function<void(bool)>>> vecDone;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        _takeDoneCallbacksNoLock(vecDone, true);
+    }
+    _runDoneCallbacks(vecDone);
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (m_pFile)
+    {
+        file_utils::syncFile(m_pFile);
+        std::fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+    m_vecSegments.clear();
+    std::cout << "[JournalManager] : released!" << std::endl;
+}
+
+std::string JournalManager::_getSegmentFileName(uint64_t index) const
+{
+    std::ostringstream oss;
+    oss << m_filePrefix << std::setw(8) << std::setfill('0') << index;
+    return oss.str();
+}
+
+bool JournalManager::replayJournal()
+{
+    const auto beginTime = std::chrono::steady_clock::now();
+
+	// find all segment files "<prefix><index>" in the working directory
+    std::vector<uint64_t> vecIndexes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(".", ec))
+    {
+        const std::string fileName = entry.path().filename().string();
+        if (fileName.size() <= m_filePrefix.size() || fileName.compare(0, m_filePrefix.size(), m_filePrefix) != 0)
+        {
+            continue;
+        }
+        const std::string strIndex = fileName.substr(m_filePrefix.size());
+        if (strIndex.find_first_not_of("0123456789") != std::string::npos)
+        {
+            continue;
+        }
+        vecIndexes.emplace_back(std::stoull(strIndex));
+    }
+    std::sort(vecIndexes.begin(), vecIndexes.end());
+
+    uint64_t replayedRecords = 0;
+    uint64_t lastSeq = 0;
+    for (uint64_t index : vecIndexes)
+    {
+        const std::string fileName = _getSegmentFileName(index);
+        FILE* pFile = file_utils::openFile(fileName, "rb");
+        if (!pFile)
+        {
+            continue;
+        }
+        Segment segment;
+        segment.m_index = index;
+
+        JournalSegmentHeader header;
+        if (std::fread(&header, sizeof(header), 1, pFile) == 1 && header.m_magic == JOURNAL_MAGIC && header.m_version == JOURNAL_VERSION)
+        {
+            JournalRecord record;
+            while (std::fread(&record, sizeof(record), 1, pFile) == 1)
+            {
+				// a torn write at the tail of the last batch, the rest was never acknowledged
+                if (record.m_checksum != calcRecordChecksum(record))
+                {
+                    std::cerr << "[WARNING] "
+                        << "[" << __FILE__ << ":" << __LINE__ << "] "
+                        << "[" << __func__ << "] "
+                        << "Broken record after seq " << lastSeq << " in " << fileName
+                        << std::endl;
+                    break;
+                }
+                if (record.m_seq <= lastSeq)
+                {
+					// written again into the next segment after a failed write, already replayed
+                    continue;
+                }
+                PlayerManager::instance().replayPlayerFromJournal(record.m_playerId, record.m_score, record.m_wins, record.m_updatedTime);
+                lastSeq = record.m_seq;
+                segment.m_lastSeq = record.m_seq;
+                replayedRecords++;
+            }
+        }
+        std::fclose(pFile);
+
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        m_vecSegments.emplace_back(segment);
+    }
+    m_lastSeq = lastSeq;
+    m_durableSeq = lastSeq;
+    m_writtenSeq = lastSeq;
+
+    if (replayedRecords > 0)
+    {
+		// compact the replayed records into player_battles, segments are removed by checkpoint
+        PlayerManager::instance().saveDirtyPlayers();
+    }
+    else
+    {
+        checkpoint(lastSeq);
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    std::cout << "[JournalManager] : replayed " << replayedRecords << " battle results from " << vecIndexes.size()
+        << " segments in " << elapsedMs << " ms." << std::endl;
+    return true;
+}
+
+bool JournalManager::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+
+        const uint64_t nextIndex = m_vecSegments.empty() ? 1 : (m_vecSegments.back().m_index + 1);
+        if (!_openSegmentNoLock(nextIndex))
+        {
+            return false;
+        }
+    }
+    m_running = true;
+    m_writerThread = std::thread(&JournalManager::writerLoop, this);
+    return true;
+}
+
+bool JournalManager::_openSegmentNoLock(uint64_t index)
+{
+    const std::string fileName = _getSegmentFileName(index);
+    FILE* pFile = file_utils::openFile(fileName, "wb");
+    if (!pFile)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to open journal segment : " << fileName
+            << std::endl;
+        return false;
+    }
+    JournalSegmentHeader header;
+    header.m_magic = JOURNAL_MAGIC;
+    header.m_version = JOURNAL_VERSION;
+    if (std::fwrite(&header, sizeof(header), 1, pFile) != 1 || !file_utils::syncFile(pFile))
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to write journal segment header : " << fileName
+            << std::endl;
+        std::fclose(pFile);
+        return false;
+    }
+    if (m_pFile)
+    {
+        file_utils::syncFile(m_pFile);
+        std::fclose(m_pFile);
+    }
+    m_pFile = pFile;
+
+    Segment segment;
+    segment.m_index = index;
+    m_vecSegments.emplace_back(segment);
+    return true;
+}
+
+uint64_t JournalManager::appendNoWait(uint64_t playerId, uint32_t score, uint32_t wins)
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    if (!m_running)
+    {
+        return 0;
+    }
+    JournalRecord record;
+    record.m_seq = ++m_lastSeq;
+    record.m_playerId = playerId;
+    record.m_score = score;
+    record.m_wins = wins;
+    record.m_updatedTime = ClockManager::instance().getTimestampMS();
+    record.m_checksum = calcRecordChecksum(record);
+    m_vecPendingRecords.emplace_back(record);
+    m_cvPending.notify_one();
+    return record.m_seq;
+}
+
+bool JournalManager::waitDurable(uint64_t seq)
+{
+    if (seq == 0)
+    {
+		// not journaled, nothing to wait for
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(m_pendingMutex);
+	// after a failed batch m_durableSeq stays before it until a checkpoint covers it, later waiters fail as well
+    m_cvDurable.wait(lock, [this, seq]() { return (m_durableSeq >= seq) || (m_failedSeq > m_durableSeq) || !m_running; });
+    return (m_durableSeq >= seq);
+}
+
+void JournalManager::callWhenDurable(uint64_t seq, std::function<void(bool)> funcDone)
+{
+    bool isDurable = true;
+    if (seq > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        if (seq > m_durableSeq && m_failedSeq <= m_durableSeq && m_running)
+        {
+			// virtual time stands still until the callback ran
+            ClockManager::instance().beginWork();
+            m_vecDurableCallbacks.push_back({ seq, std::move(funcDone) });
+            return;
+        }
+        isDurable = (m_durableSeq >= seq);
+    }
+    funcDone(isDurable);
+}
+
+void JournalManager::_takeDoneCallbacksNoLock(std::vector<std::pair<bool, std::function<void(bool)>>>& refVecDone, bool isStopped)
+{
+    const bool isFailed = (m_failedSeq > m_durableSeq) || isStopped;
+    auto itKeep = m_vecDurableCallbacks.begin();
+    for (auto& callback : m_vecDurableCallbacks)
+    {
+        const bool isDurable = (m_durableSeq >= callback.m_seq);
+        if (isDurable || isFailed)
+        {
+            refVecDone.emplace_back(isDurable, std::move(callback.m_funcDone));
+        }
+        else
+        {
+            *itKeep++ = std::move(callback);
+        }
+    }
+    m_vecDurableCallbacks.erase(itKeep, m_vecDurableCallbacks.end());
+}
+
+void JournalManager::_runDoneCallbacks(std::vector<std::pair<bool, std::function<void(bool)>>>& refVecDone)
+{
+    for (auto& done : refVecDone)
+    {
+        done.second(done.first);
+        ClockManager::instance().endWork();
+    }
+    refVecDone.clear();
+}
+
+// handler for the writer thread, every wake up writes all pending records with one sync (group commit)
+void JournalManager::writerLoop()
+{
+    std::vector<JournalRecord> vecBatch;
+    std::vector<std::pair<bool, std::function<void(bool)>>> vecDone;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_pendingMutex);
+            m_cvPending.wait(lock, [this]() { return !m_vecPendingRecords.empty() || !m_running; });
+            if (m_vecPendingRecords.empty())
+            {
+				// stopped and nothing left to write
+                break;
+            }
+            vecBatch.swap(m_vecPendingRecords);
+        }
+
+        bool isOk = false;
+        {
+            std::lock_guard<std::mutex> lock(m_fileMutex);
+            isOk = _writeBatchNoLock(vecBatch);
+        }
+        if (!isOk)
+        {
+            std::cerr << "[ERROR] "
+                << "[" << __FILE__ << ":" << __LINE__ << "] "
+                << "[" << __func__ << "] "
+                << "Failed to write " << vecBatch.size() << " journal records (seq " << vecBatch.front().m_seq
+                << " - " << vecBatch.back().m_seq << "), they are kept only until the next flush."
+                << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMutex);
+            if (isOk)
+            {
+                m_writtenSeq = vecBatch.back().m_seq;
+				// durable only if no failed batch is left before it
+                if (m_failedSeq <= m_durableSeq)
+                {
+                    m_durableSeq = m_writtenSeq;
+                }
+            }
+            else
+            {
+                m_failedSeq = vecBatch.back().m_seq;
+            }
+            _takeDoneCallbacksNoLock(vecDone);
+        }
+        m_cvDurable.notify_all();
+        _runDoneCallbacks(vecDone);
+        vecBatch.clear();
+    }
+}
+
+bool JournalManager::_writeBatchNoLock(const std::vector<JournalRecord>& vecBatch)
+{
+    for (int attempt = 0; attempt < JOURNAL_WRITE_ATTEMPTS; attempt++)
+    {
+		// the failed segment may end with a part of the batch, replay skips the records written again
+        if (attempt > 0 && !_openSegmentNoLock(m_vecSegments.back().m_index + 1))
+        {
+            continue;
+        }
+        if (!m_pFile)
+        {
+            return false;
+        }
+        if (std::fwrite(vecBatch.data(), sizeof(JournalRecord), vecBatch.size(), m_pFile) == vecBatch.size() && file_utils::syncFile(m_pFile))
+        {
+            m_vecSegments.back().m_lastSeq = vecBatch.back().m_seq;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JournalManager::checkpoint(uint64_t flushedSeq)
+{
+    std::vector<std::pair<bool, std::function<void(bool)>>> vecDone;
+    {
+		// records flushed into db are durable, a failed batch covered by the flush is healed
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        if (flushedSeq > m_durableSeq)
+        {
+            m_durableSeq = (m_failedSeq <= flushedSeq) ? std::max(flushedSeq, m_writtenSeq) : flushedSeq;
+        }
+        _takeDoneCallbacksNoLock(vecDone);
+    }
+    m_cvDurable.notify_all();
+    _runDoneCallbacks(vecDone);
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+
+	// rotate the current segment so it can be removed once it is covered
+    if (m_pFile && !m_vecSegments.empty() && m_vecSegments.back().m_lastSeq > 0)
+    {
+        _openSegmentNoLock(m_vecSegments.back().m_index + 1);
+    }
+    _removeSegmentsNoLock(flushedSeq);
+}
+
+void JournalManager::_removeSegmentsNoLock(uint64_t flushedSeq)
+{
+	// the last segment is the current one while the writer is running
+    const size_t removableCounts = m_pFile ? (m_vecSegments.size() - 1) : m_vecSegments.size();
+    size_t removedCounts = 0;
+    for (size_t i = 0; i < removableCounts; i++)
+    {
+        if (m_vecSegments[i].m_lastSeq > flushedSeq)
+        {
+            break;
+        }
+        std::remove(_getSegmentFileName(m_vecSegments[i].m_index).c_str());
+        removedCounts++;
+    }
+    m_vecSegments.erase(m_vecSegments.begin(), m_vecSegments.begin() + removedCounts);
+}
@@ -0,0 +1,117 @@
+// journalManager.h
+#ifndef JOURNAL_MANAGER_H
+#define JOURNAL_MANAGER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+
+// one battle result, holds the absolute player data after the battle so replay is idempotent
+struct JournalRecord
+{
+	uint64_t m_seq = 0;             // journal sequence, increasing
+	uint64_t m_playerId = 0;        // player ID
+	uint32_t m_score = 0;           // score after the battle
+	uint32_t m_wins = 0;            // wins after the battle
+	uint64_t m_updatedTime = 0;     // timestamp(ms) of the battle result
+	uint32_t m_checksum = 0;        // checksum of the fields above
+	uint32_t m_reserved = 0;
+};
+
+// journal segment file : [JournalSegmentHeader][JournalRecord ...]
+struct JournalSegmentHeader
+{
+	uint32_t m_magic = 0;           // JOURNAL_MAGIC
+	uint32_t m_version = 0;         // JOURNAL_VERSION
+};
+
+class JournalManager
+{
+public:
+    static JournalManager& instance();
+
+    bool initialize();
+    void release();
+
+	// replay all journal segments into PlayerManager, flush them into db and remove the segments
+    bool replayJournal();
+	// open a new segment and start the group commit writer thread
+    bool start();
+
+	// append a battle result, returns the sequence (0 if journal is not running)
+	// *** must be called under the lock which protects the player data, so sequence order matches data order ***
+    uint64_t appendNoWait(uint64_t playerId, uint32_t score, uint32_t wins);
+	// block until the record with the sequence is written and synced to disk
+	// false if the journal failed to write it or stopped before, the result is only in memory until the next flush
+    bool waitDurable(uint64_t seq);
+	// the same without blocking, funcDone(isDurable) runs inline if the result is known, otherwise on the writer thread after the sync
+	// *** keep funcDone short, the next batch waits for it ***
+    void callWhenDurable(uint64_t seq, std::function<void(bool)> funcDone);
+
+	// all records up to flushedSeq are persisted in player_battles, remove the segments covered by it
+    void checkpoint(uint64_t flushedSeq);
+
+    uint64_t getLastSeq() const { return m_lastSeq.load(); }
+
+private:
+    JournalManager();
+    ~JournalManager();
+
+    JournalManager(const JournalManager&) = delete;
+    JournalManager& operator=(const JournalManager&) = delete;
+    JournalManager(JournalManager&&) = delete;
+    JournalManager& operator=(JournalManager&&) = delete;
+
+    struct DurableCallback
+    {
+        uint64_t m_seq = 0;
+        std::function<void(bool)> m_funcDone;
+    };
+
+    struct Segment
+    {
+        uint64_t m_index = 0;       // segment file index
+        uint64_t m_lastSeq = 0;     // last sequence written into the segment
+    };
+
+    void writerLoop();
+	// write and sync one batch into the current segment, a failed attempt moves to a new segment and retries
+    bool _writeBatchNoLock(const std::vector<JournalRecord>& vecBatch);
+	// move the callbacks whose result is known (all of them if isStopped) into refVecDone, with the result
+    void _takeDoneCallbacksNoLock(std::vector<std::pair<bool, std::function<void(bool)>>>& refVecDone, bool isStopped = false);
+	// run the callbacks taken without the lock
+    void _runDoneCallbacks(std::vector<std::pair<bool, std::function<void(bool)>>>& refVecDone);
+
+	// private methods without lock
+    bool _openSegmentNoLock(uint64_t index);
+    void _removeSegmentsNoLock(uint64_t flushedSeq);
+    std::string _getSegmentFileName(uint64_t index) const;
+
+    std::string m_filePrefix = "";
+
+    std::vector<JournalRecord> m_vecPendingRecords{};   // records waiting for the writer
+	std::atomic<uint64_t> m_lastSeq = 0;                // last assigned sequence
+	uint64_t m_durableSeq = 0;                          // all sequences up to it are synced to disk or flushed into db
+	uint64_t m_writtenSeq = 0;                          // last sequence of the last batch synced to disk
+	uint64_t m_failedSeq = 0;                           // last sequence of the last batch failed to write, 0 if none
+	std::vector<DurableCallback> m_vecDurableCallbacks{};   // callbacks waiting for their sequence
+	std::mutex m_pendingMutex;                          // lock for m_vecPendingRecords, m_durableSeq, m_writtenSeq, m_failedSeq, m_vecDurableCallbacks
+	std::condition_variable m_cvPending;                // wake up the writer
+	std::condition_variable m_cvDurable;                // wake up the waiters after sync
+
+	FILE* m_pFile = nullptr;                            // current segment file
+	std::vector<Segment> m_vecSegments{};               // segments not yet checkpointed, the last one is current
+	std::mutex m_fileMutex;                             // lock for m_pFile, m_vecSegments
+
+	std::thread m_writerThread;                         // group commit writer thread
+	std::atomic<bool> m_running = false;                // thread control flag
+};
+
+#endif // JOURNAL_MANAGER_H
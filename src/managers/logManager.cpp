@@ -0,0 +1,293 @@
+// @file  : logManager.cpp
+// @brief : asynchronous logger with per-thread lock-free rings
+// @author: August
+// @date  : 2025-06-14
+#include "logManager.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+const std::chrono::milliseconds LOG_SINK_IDLE_WAIT(100);   // longest sleep of the sink, bounds a missed wake-up
+
+// ring of the calling thread, closed when the thread exits
+struct LogThreadRing
+{
+    std::shared_ptr<LogManager::LogRing> m_pRing;
+
+    ~LogThreadRing()
+    {
+        if (m_pRing)
+        {
+            m_pRing->m_isClosed.store(true, std::memory_order_release);
+        }
+    }
+};
+static thread_local LogThreadRing t_threadRing;
+
+LogManager& LogManager::instance()
+{
+    static LogManager instance;
+    return instance;
+}
+
+LogManager::LogManager()
+{
+}
+
+LogManager::~LogManager()
+{
+}
+
+bool LogManager::initialize()
+{
+    if (m_running)
+    {
+        return true;
+    }
+    m_isSinkSleeping = false;
+    m_running = true;
+    m_sinkThread = std::thread(&LogManager::sinkLoop, this);
+
+    std::cout << "[LogManager] : initialized! (level " << getLevelName(getLevel()) << ")" << std::endl;
+    return true;
+}
+
+void LogManager::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        m_running = false;
+    }
+    m_cvSink.notify_all();
+    if (m_sinkThread.joinable())
+    {
+		// the sink writes the remaining records before it exits
+        m_sinkThread.join();
+    }
+    std::cout << "[LogManager] : released! (" << m_writtenRecords << " records, " << m_droppedRecords << " dropped)" << std::endl;
+}
+
+bool LogManager::parseLevel(const std::string& name, logging::LogLevel& refLevel)
+{
+    if (name == "debug")
+    {
+        refLevel = logging::LogLevel::LogLevelDebug;
+    }
+    else if (name == "info")
+    {
+        refLevel = logging::LogLevel::LogLevelInfo;
+    }
+    else if (name == "warning")
+    {
+        refLevel = logging::LogLevel::LogLevelWarning;
+    }
+    else if (name == "error")
+    {
+        refLevel = logging::LogLevel::LogLevelError;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char* LogManager::getLevelName(logging::LogLevel level)
+{
+    switch (level)
+    {
+    case logging::LogLevel::LogLevelDebug:
+        return "debug";
+    case logging::LogLevel::LogLevelInfo:
+        return "info";
+    case logging::LogLevel::LogLevelWarning:
+        return "warning";
+    case logging::LogLevel::LogLevelError:
+        return "error";
+    default:
+        return "unknown";
+    }
+}
+
+void LogManager::_push(LogRecord& refRecord)
+{
+    refRecord.m_sequence = m_nextSequence.fetch_add(1, std::memory_order_relaxed);
+    if (!m_running.load(std::memory_order_acquire))
+    {
+		// before initialize or after release, write synchronously
+        std::string output;
+        _formatRecord(refRecord, output);
+        std::lock_guard<std::mutex> lock(m_inlineMutex);
+        (refRecord.m_level >= logging::LogLevel::LogLevelWarning ? std::cerr : std::cout) << output << std::flush;
+        m_writtenRecords.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (!t_threadRing.m_pRing)
+    {
+        t_threadRing.m_pRing = _registerRing();
+    }
+    LogRing& refRing = *t_threadRing.m_pRing;
+    const uint64_t tail = refRing.m_tail.load(std::memory_order_relaxed);
+    if (tail - refRing.m_head.load(std::memory_order_acquire) >= RING_CAPACITY)
+    {
+		// never block the caller, the sink is behind
+        m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    refRing.m_arrRecords[tail & (RING_CAPACITY - 1)] = refRecord;
+    refRing.m_tail.store(tail + 1, std::memory_order_release);
+
+	// only the first record after the sink went to sleep pays for the notify
+    if (m_isSinkSleeping.load(std::memory_order_relaxed) && m_isSinkSleeping.exchange(false))
+    {
+        m_cvSink.notify_one();
+    }
+}
+
+std::shared_ptr<LogManager::LogRing> LogManager::_registerRing()
+{
+    auto pRing = std::make_shared<LogRing>();
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    m_vecRings.emplace_back(pRing);
+    return pRing;
+}
+
+size_t LogManager::_collectRecords(std::vector<LogRecord>& refVecRecords)
+{
+    refVecRecords.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        for (auto it = m_vecRings.begin(); it != m_vecRings.end();)
+        {
+            LogRing& refRing = **it;
+			// read the flag first, records pushed before the thread exited are then visible
+            const bool isClosed = refRing.m_isClosed.load(std::memory_order_acquire);
+            const uint64_t head = refRing.m_head.load(std::memory_order_relaxed);
+            const uint64_t tail = refRing.m_tail.load(std::memory_order_acquire);
+            for (uint64_t i = head; i < tail; i++)
+            {
+                refVecRecords.emplace_back(refRing.m_arrRecords[i & (RING_CAPACITY - 1)]);
+            }
+            refRing.m_head.store(tail, std::memory_order_release);
+
+            if (isClosed)
+            {
+                it = m_vecRings.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+
+	// merge the threads back into call order
+    std::sort(refVecRecords.begin(), refVecRecords.end(),
+        [](const LogRecord& lhs, const LogRecord& rhs) { return lhs.m_sequence < rhs.m_sequence; });
+    return refVecRecords.size();
+}
+
+void LogManager::_formatRecord(const LogRecord& refRecord, std::string& refOutput)
+{
+    refOutput.clear();
+    if (refRecord.m_level == logging::LogLevel::LogLevelWarning)
+    {
+        refOutput += "[WARNING] ";
+    }
+    else if (refRecord.m_level == logging::LogLevel::LogLevelError)
+    {
+        refOutput += "[ERROR] ";
+    }
+
+    uint8_t argIndex = 0;
+    for (const char* pChar = refRecord.m_format; pChar && *pChar; pChar++)
+    {
+        if (pChar[0] != '{' || pChar[1] != '}' || argIndex >= refRecord.m_argCounts)
+        {
+            refOutput += *pChar;
+            continue;
+        }
+
+        const LogArg& refArg = refRecord.m_arrArgs[argIndex++];
+        switch (refArg.m_type)
+        {
+        case LogArg::ArgTypeUnsigned:
+            refOutput += std::to_string(refArg.m_unsigned);
+            break;
+        case LogArg::ArgTypeSigned:
+            refOutput += std::to_string(refArg.m_signed);
+            break;
+        case LogArg::ArgTypeDouble:
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%g", refArg.m_double);
+            refOutput += buffer;
+            break;
+        }
+        case LogArg::ArgTypeBool:
+            refOutput += refArg.m_bool ? "true" : "false";
+            break;
+        case LogArg::ArgTypeString:
+            refOutput += refArg.m_string ? refArg.m_string : "(null)";
+            break;
+        }
+		pChar++;    // skip '}'
+    }
+    refOutput += '\n';
+}
+
+void LogManager::_writeRecords(std::vector<LogRecord>& refVecRecords, std::string& refOutput)
+{
+    std::string line;
+    std::string errorOutput;
+    refOutput.clear();
+    for (const auto& record : refVecRecords)
+    {
+        _formatRecord(record, line);
+        (record.m_level >= logging::LogLevel::LogLevelWarning ? errorOutput : refOutput) += line;
+    }
+
+	// one write and one flush per batch
+    if (!refOutput.empty())
+    {
+        std::cout << refOutput << std::flush;
+    }
+    if (!errorOutput.empty())
+    {
+        std::cerr << errorOutput << std::flush;
+    }
+    m_writtenRecords.fetch_add(refVecRecords.size(), std::memory_order_relaxed);
+}
+
+// handler for the sink thread
+void LogManager::sinkLoop()
+{
+    std::vector<LogRecord> vecRecords;
+    std::string output;
+    while (true)
+    {
+        const bool isRunning = m_running.load();
+        if (_collectRecords(vecRecords) > 0)
+        {
+            _writeRecords(vecRecords, output);
+            continue;
+        }
+        if (!isRunning)
+        {
+			// stopped and every ring is empty
+            break;
+        }
+
+		// announce the sleep, then look once more so a record pushed in between is not left waiting
+        m_isSinkSleeping = true;
+        if (_collectRecords(vecRecords) > 0)
+        {
+            m_isSinkSleeping = false;
+            _writeRecords(vecRecords, output);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sinkMutex);
+        m_cvSink.wait_for(lock, LOG_SINK_IDLE_WAIT, [this]() { return !m_isSinkSleeping.load() || !m_running.load(); });
+        m_isSinkSleeping = false;
+    }
+}
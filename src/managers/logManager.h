@@ -0,0 +1,182 @@
+// logManager.h
+#ifndef LOG_MANAGER_H
+#define LOG_MANAGER_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <cstdint>
+#include "../../include/globalDefine.h"
+
+// one argument of a log record, stored raw and formatted by the sink thread
+struct LogArg
+{
+    enum ArgType : uint8_t
+    {
+        ArgTypeUnsigned,
+        ArgTypeSigned,
+        ArgTypeDouble,
+        ArgTypeBool,
+        ArgTypeString       // pointer to a string that outlives the record (literal, static)
+    };
+
+    ArgType m_type = ArgTypeUnsigned;
+    union
+    {
+        uint64_t m_unsigned;
+        int64_t m_signed;
+        double m_double;
+        bool m_bool;
+        const char* m_string;
+    };
+
+    LogArg() : m_unsigned(0) {}
+};
+
+// a log line before formatting
+struct LogRecord
+{
+    static const size_t MAX_ARGS = 8;
+
+	uint64_t m_sequence = 0;            // global order of the records over all threads
+	const char* m_format = nullptr;     // string literal, "{}" is replaced by the next argument
+    logging::LogLevel m_level = logging::LogLevel::LogLevelInfo;
+    uint8_t m_argCounts = 0;
+    LogArg m_arrArgs[MAX_ARGS];
+};
+
+// asynchronous logger
+// every thread writes to its own lock-free ring (single producer, the sink thread is the single consumer),
+// a background sink thread merges the rings in sequence order, formats the records and writes them in batches
+// a full ring drops the record instead of blocking the caller, the dropped counts are reported by the sink
+// *** format strings and string arguments are read later by the sink thread, only pass literals or static strings ***
+class LogManager
+{
+public:
+    static LogManager& instance();
+
+    bool initialize();
+	// write the remaining records and stop the sink thread
+    void release();
+
+    void setLevel(logging::LogLevel level) { m_level.store(level, std::memory_order_relaxed); }
+    logging::LogLevel getLevel() const { return m_level.load(std::memory_order_relaxed); }
+    bool isEnabled(logging::LogLevel level) const { return level >= getLevel(); }
+	// parse "debug", "info", "warning" or "error"
+    static bool parseLevel(const std::string& name, logging::LogLevel& refLevel);
+    static const char* getLevelName(logging::LogLevel level);
+
+    template <typename... Args>
+    void log(logging::LogLevel level, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "LogManager::log: too many arguments.");
+        if (!isEnabled(level))
+        {
+            return;
+        }
+        LogRecord record;
+        record.m_format = format;
+        record.m_level = level;
+        record.m_argCounts = static_cast<uint8_t>(sizeof...(Args));
+        size_t index = 0;
+        (void)index;
+        (_setArg(record.m_arrArgs[index++], args), ...);
+        _push(record);
+    }
+
+    uint64_t getWrittenRecords() const { return m_writtenRecords.load(std::memory_order_relaxed); }
+    uint64_t getDroppedRecords() const { return m_droppedRecords.load(std::memory_order_relaxed); }
+
+private:
+    LogManager();
+    ~LogManager();
+
+    LogManager(const LogManager&) = delete;
+    LogManager& operator=(const LogManager&) = delete;
+    LogManager(LogManager&&) = delete;
+    LogManager& operator=(LogManager&&) = delete;
+
+    static const size_t RING_CAPACITY = 2048;   // records per thread, power of two
+
+	// single-producer single-consumer ring of one thread
+    struct LogRing
+    {
+        alignas(64) std::atomic<uint64_t> m_head{ 0 };     // next record to read, written by the sink
+        alignas(64) std::atomic<uint64_t> m_tail{ 0 };     // next free slot, written by the owner thread
+		std::atomic<bool> m_isClosed{ false };              // the owner thread exited, removed once empty
+        LogRecord m_arrRecords[RING_CAPACITY];
+    };
+    friend struct LogThreadRing;
+
+    template <typename T>
+    static void _setArg(LogArg& refArg, const T& value)
+    {
+        if constexpr (std::is_same<T, bool>::value)
+        {
+            refArg.m_type = LogArg::ArgTypeBool;
+            refArg.m_bool = value;
+        }
+        else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+        {
+            refArg.m_type = LogArg::ArgTypeSigned;
+            refArg.m_signed = static_cast<int64_t>(value);
+        }
+        else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value)
+        {
+            refArg.m_type = LogArg::ArgTypeUnsigned;
+            refArg.m_unsigned = static_cast<uint64_t>(value);
+        }
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            refArg.m_type = LogArg::ArgTypeDouble;
+            refArg.m_double = static_cast<double>(value);
+        }
+        else
+        {
+            static_assert(std::is_convertible<const T&, const char*>::value, "LogManager::log: unsupported argument type (std::string is not supported, the record outlives it).");
+            refArg.m_type = LogArg::ArgTypeString;
+            refArg.m_string = value;
+        }
+    }
+
+	// copy the record to the ring of the calling thread, formats it inline if the sink is not running
+    void _push(LogRecord& refRecord);
+	// create the ring of the calling thread
+    std::shared_ptr<LogRing> _registerRing();
+    void sinkLoop();
+	// move the records of all rings to refVecRecords, drop the empty closed rings
+    size_t _collectRecords(std::vector<LogRecord>& refVecRecords);
+    static void _formatRecord(const LogRecord& refRecord, std::string& refOutput);
+    void _writeRecords(std::vector<LogRecord>& refVecRecords, std::string& refOutput);
+
+    std::vector<std::shared_ptr<LogRing>> m_vecRings{};
+	std::mutex m_ringsMutex;                        // lock for m_vecRings, only taken once per thread and by the sink
+	std::mutex m_sinkMutex;                         // lock for m_cvSink
+	std::condition_variable m_cvSink;               // wake up the sink thread
+	std::atomic<bool> m_isSinkSleeping = false;     // the sink waits for records, producers wake it up
+	std::thread m_sinkThread;
+	std::atomic<bool> m_running = false;
+	std::mutex m_inlineMutex;                       // serializes the records formatted without the sink
+
+	std::atomic<logging::LogLevel> m_level = logging::LogLevel::LogLevelInfo;
+	std::atomic<uint64_t> m_nextSequence = 0;
+	std::atomic<uint64_t> m_writtenRecords = 0;
+	std::atomic<uint64_t> m_droppedRecords = 0;
+};
+
+// per-event lines, compiled out in release builds (NDEBUG) unless LOG_DEBUG_IN_RELEASE is defined
+#if defined(NDEBUG) && !defined(LOG_DEBUG_IN_RELEASE)
+#define LOG_DEBUG(...) ((void)0)
+#else
+#define LOG_DEBUG(...) LogManager::instance().log(logging::LogLevel::LogLevelDebug, __VA_ARGS__)
+#endif
+#define LOG_INFO(...) LogManager::instance().log(logging::LogLevel::LogLevelInfo, __VA_ARGS__)
+#define LOG_WARNING(...) LogManager::instance().log(logging::LogLevel::LogLevelWarning, __VA_ARGS__)
+#define LOG_ERROR(...) LogManager::instance().log(logging::LogLevel::LogLevelError, __VA_ARGS__)
+
+#endif // LOG_MANAGER_H
@@ -0,0 +1,393 @@
+// @file  : metricsManager.cpp
+// @brief : Prometheus metrics endpoint on a local HTTP port
+// @author: August
+// @date  : 2025-06-17
+#include "metricsManager.h"
+#include "battleManager.h"
+#include "playerManager.h"
+#include "dbManager.h"
+#include "scheduleManager.h"
+#include "executorManager.h"
+#include "logManager.h"
+#include "../../include/globalDefine.h"
+#include "../../utils/histogram.h"
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+const int METRICS_ACCEPT_TIMEOUT_MS = 200;          // the server thread checks m_running this often
+const int METRICS_RECV_TIMEOUT_MS = 2000;           // a client that sends nothing is dropped
+const size_t METRICS_MAX_REQUEST_SIZE = 8192;
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+const intptr_t METRICS_INVALID_SOCKET = static_cast<intptr_t>(INVALID_SOCKET);
+#else
+using NativeSocket = int;
+const intptr_t METRICS_INVALID_SOCKET = -1;
+#endif
+
+// the header keeps the socket as intptr_t, so it does not need the socket headers
+static NativeSocket toNative(intptr_t socketHandle)
+{
+    return static_cast<NativeSocket>(socketHandle);
+}
+
+// send the whole buffer, false if the client is gone
+static bool sendAll(intptr_t socketHandle, const std::string& refData)
+{
+    size_t sent = 0;
+    while (sent < refData.size())
+    {
+#ifdef _WIN32
+        const int rc = send(toNative(socketHandle), refData.data() + sent, static_cast<int>(refData.size() - sent), 0);
+#else
+        const ssize_t rc = send(toNative(socketHandle), refData.data() + sent, refData.size() - sent, MSG_NOSIGNAL);
+#endif
+        if (rc <= 0)
+        {
+            return false;
+        }
+        sent += static_cast<size_t>(rc);
+    }
+    return true;
+}
+
+static std::string makeResponse(const char* status, const char* contentType, const std::string& refBody)
+{
+    std::ostringstream oss;
+    oss << "HTTP/1.1 " << status << "\r\n"
+        << "Content-Type: " << contentType << "\r\n"
+        << "Content-Length: " << refBody.size() << "\r\n"
+        << "Connection: close\r\n"
+        << "\r\n"
+        << refBody;
+    return oss.str();
+}
+
+MetricsManager& MetricsManager::instance()
+{
+    static MetricsManager instance;
+    return instance;
+}
+
+MetricsManager::MetricsManager()
+{
+}
+
+MetricsManager::~MetricsManager()
+{
+}
+
+bool MetricsManager::initialize(uint16_t port)
+{
+    if (m_running)
+    {
+        return true;
+    }
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "WSAStartup failed."
+            << std::endl;
+        return false;
+    }
+#endif
+
+    const intptr_t listenSocket = static_cast<intptr_t>(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (listenSocket == METRICS_INVALID_SOCKET)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to create the metrics socket."
+            << std::endl;
+        return false;
+    }
+    int isReuse = 1;
+    setsockopt(toNative(listenSocket), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&isReuse), sizeof(isReuse));
+
+	// localhost only, the endpoint has no authentication
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(toNative(listenSocket), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(toNative(listenSocket), 16) != 0)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to listen on 127.0.0.1:" << port
+            << std::endl;
+        _closeSocket(listenSocket);
+        return false;
+    }
+
+    m_listenSocket = listenSocket;
+    m_port = port;
+    m_scrapes = 0;
+    m_running = true;
+    m_serverThread = std::thread(&MetricsManager::serverLoop, this);
+
+    std::cout << "[MetricsManager] : initialized! (http://127.0.0.1:" << port << "/metrics)" << std::endl;
+    return true;
+}
+
+void MetricsManager::release()
+{
+    if (!m_running)
+    {
+        return;
+    }
+    m_running = false;
+    if (m_serverThread.joinable())
+    {
+		// the accept wait times out within METRICS_ACCEPT_TIMEOUT_MS
+        m_serverThread.join();
+    }
+    _closeSocket(m_listenSocket);
+    m_listenSocket = METRICS_INVALID_SOCKET;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    std::cout << "[MetricsManager] : released! (" << m_scrapes.load() << " scrapes)" << std::endl;
+}
+
+// handler for the server thread
+void MetricsManager::serverLoop()
+{
+    while (m_running)
+    {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(toNative(m_listenSocket), &readSet);
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = METRICS_ACCEPT_TIMEOUT_MS * 1000;
+        const int ready = select(static_cast<int>(m_listenSocket + 1), &readSet, nullptr, nullptr, &timeout);
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        const intptr_t clientSocket = static_cast<intptr_t>(accept(toNative(m_listenSocket), nullptr, nullptr));
+        if (clientSocket == METRICS_INVALID_SOCKET)
+        {
+            continue;
+        }
+        _handleConnection(clientSocket);
+        _closeSocket(clientSocket);
+    }
+}
+
+void MetricsManager::_handleConnection(intptr_t clientSocket)
+{
+#ifdef _WIN32
+    const DWORD recvTimeout = METRICS_RECV_TIMEOUT_MS;
+#else
+    timeval recvTimeout;
+    recvTimeout.tv_sec = METRICS_RECV_TIMEOUT_MS / 1000;
+    recvTimeout.tv_usec = (METRICS_RECV_TIMEOUT_MS % 1000) * 1000;
+#endif
+    setsockopt(toNative(clientSocket), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&recvTimeout), sizeof(recvTimeout));
+
+	// read up to the end of the headers, the body of a GET is ignored
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < METRICS_MAX_REQUEST_SIZE)
+    {
+        const int rc = static_cast<int>(recv(toNative(clientSocket), buffer, sizeof(buffer), 0));
+        if (rc <= 0)
+        {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(rc));
+    }
+
+	// request line : "<method> <path> HTTP/1.x"
+    std::istringstream iss(request.substr(0, request.find("\r\n")));
+    std::string method;
+    std::string path;
+    iss >> method >> path;
+    if (method.empty())
+    {
+        return;
+    }
+    if (method != "GET")
+    {
+        sendAll(clientSocket, makeResponse("405 Method Not Allowed", "text/plain; charset=utf-8", "only GET is supported\n"));
+        return;
+    }
+    if (path != "/metrics" && path.rfind("/metrics?", 0) != 0)
+    {
+        sendAll(clientSocket, makeResponse("404 Not Found", "text/plain; charset=utf-8", "see /metrics\n"));
+        return;
+    }
+    m_scrapes.fetch_add(1, std::memory_order_relaxed);
+    sendAll(clientSocket, makeResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8", collectMetrics()));
+}
+
+void MetricsManager::_closeSocket(intptr_t socketHandle)
+{
+    if (socketHandle == METRICS_INVALID_SOCKET)
+    {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(toNative(socketHandle));
+#else
+    close(toNative(socketHandle));
+#endif
+}
+
+void MetricsManager::_writeHeader(std::ostringstream& refOss, const char* name, const char* help, const char* type)
+{
+    refOss << "# HELP " << name << " " << help << "\n";
+    refOss << "# TYPE " << name << " " << type << "\n";
+}
+
+void MetricsManager::_writeSample(std::ostringstream& refOss, const char* name, const std::string& labels, double value)
+{
+    refOss << name;
+    if (!labels.empty())
+    {
+        refOss << "{" << labels << "}";
+    }
+    refOss << " " << value << "\n";
+}
+
+void MetricsManager::_writeHistogram(std::ostringstream& refOss, const char* name, const std::string& labels, const LatencyHistogram& refHistogram)
+{
+    const std::string labelPrefix = labels.empty() ? "" : (labels + ",");
+
+	// the count is the sum of the read buckets, so +Inf matches it even while other threads record
+	// only the power-of-two bounds are written, the sub-buckets would make hundreds of series per histogram
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i + 1 < LatencyHistogram::BUCKET_COUNTS; i++)
+    {
+        cumulative += refHistogram.getBucketCount(i);
+        if (!LatencyHistogram::isPowerOfTwoBound(i))
+        {
+            continue;
+        }
+        refOss << name << "_bucket{" << labelPrefix << "le=\"" << (LatencyHistogram::getBucketUpperBound(i) / 1000000.0) << "\"} " << cumulative << "\n";
+    }
+    cumulative += refHistogram.getBucketCount(LatencyHistogram::BUCKET_COUNTS - 1);
+    refOss << name << "_bucket{" << labelPrefix << "le=\"+Inf\"} " << cumulative << "\n";
+    _writeSample(refOss, (std::string(name) + "_sum").c_str(), labels, refHistogram.getSum() / 1000000.0);
+    _writeSample(refOss, (std::string(name) + "_count").c_str(), labels, static_cast<double>(cumulative));
+}
+
+std::string MetricsManager::collectMetrics()
+{
+    BattleManager& refBattle = BattleManager::instance();
+    PlayerManager& refPlayer = PlayerManager::instance();
+    DbManager& refDb = DbManager::instance();
+    ScheduleManager& refSchedule = ScheduleManager::instance();
+    ExecutorManager& refExecutor = ExecutorManager::instance();
+
+    std::ostringstream oss;
+    oss << std::setprecision(12);
+
+	// matchmaking
+    _writeHeader(oss, "gamematch_queue_players", "Players waiting in the team and battle queues.", "gauge");
+    for (uint32_t tier = battle::Tier::TierMin; tier <= battle::Tier::TierMax; tier++)
+    {
+        _writeSample(oss, "gamematch_queue_players", "tier=\"" + std::to_string(tier) + "\"", static_cast<double>(refBattle.getTierStats(tier).m_queuedPlayers.load(std::memory_order_relaxed)));
+    }
+    _writeHeader(oss, "gamematch_queue_teams", "Teams waiting in the battle queue.", "gauge");
+    for (uint32_t tier = battle::Tier::TierMin; tier <= battle::Tier::TierMax; tier++)
+    {
+        _writeSample(oss, "gamematch_queue_teams", "tier=\"" + std::to_string(tier) + "\"", static_cast<double>(refBattle.getTierStats(tier).m_queuedTeams.load(std::memory_order_relaxed)));
+    }
+    _writeHeader(oss, "gamematch_queue_enqueued_total", "Players put into the queue.", "counter");
+    _writeSample(oss, "gamematch_queue_enqueued_total", "", static_cast<double>(refBattle.getEnqueuedPlayers()));
+    _writeHeader(oss, "gamematch_battle_rooms_active", "Battle rooms created and not yet finished.", "gauge");
+    _writeSample(oss, "gamematch_battle_rooms_active", "", static_cast<double>(refBattle.getActiveRooms()));
+    _writeHeader(oss, "gamematch_battle_rooms_per_second", "Battle rooms created per second over the last second.", "gauge");
+    _writeSample(oss, "gamematch_battle_rooms_per_second", "", refBattle.getRoomsPerSec());
+    _writeHeader(oss, "gamematch_battles_started_total", "Battle rooms created.", "counter");
+    _writeSample(oss, "gamematch_battles_started_total", "", static_cast<double>(refBattle.getStartedBattles()));
+    _writeHeader(oss, "gamematch_battles_finished_total", "Battles finished.", "counter");
+    _writeSample(oss, "gamematch_battles_finished_total", "", static_cast<double>(refBattle.getFinishedBattles()));
+    _writeHeader(oss, "gamematch_queue_wait_seconds", "Time from joining the queue to entering a battle room.", "histogram");
+    _writeHistogram(oss, "gamematch_queue_wait_seconds", "", refBattle.getQueueWaitHistogram());
+    _writeHeader(oss, "gamematch_team_wait_seconds", "Time from joining the queue to the team being formed.", "histogram");
+    for (uint32_t tier = battle::Tier::TierMin; tier <= battle::Tier::TierMax; tier++)
+    {
+        _writeHistogram(oss, "gamematch_team_wait_seconds", "tier=\"" + std::to_string(tier) + "\"", refBattle.getTierStats(tier).m_teamWaitHistogram);
+    }
+    _writeHeader(oss, "gamematch_battle_wait_seconds", "Time from the team being formed to entering a battle room.", "histogram");
+    for (uint32_t tier = battle::Tier::TierMin; tier <= battle::Tier::TierMax; tier++)
+    {
+        _writeHistogram(oss, "gamematch_battle_wait_seconds", "tier=\"" + std::to_string(tier) + "\"", refBattle.getTierStats(tier).m_battleWaitHistogram);
+    }
+
+	// players
+    _writeHeader(oss, "gamematch_players_online", "Players logged in.", "gauge");
+    _writeSample(oss, "gamematch_players_online", "", static_cast<double>(refPlayer.getOnlinePlayerCounts()));
+    _writeHeader(oss, "gamematch_players_dirty", "Players waiting to be saved.", "gauge");
+    _writeSample(oss, "gamematch_players_dirty", "", static_cast<double>(refPlayer.getDirtyPlayerCounts()));
+    _writeHeader(oss, "gamematch_player_logins_total", "Player logins.", "counter");
+    _writeSample(oss, "gamematch_player_logins_total", "", static_cast<double>(refPlayer.getLogins()));
+    _writeHeader(oss, "gamematch_player_battle_results_total", "Battle results applied to players.", "counter");
+    _writeSample(oss, "gamematch_player_battle_results_total", "", static_cast<double>(refPlayer.getBattleResults()));
+    _writeHeader(oss, "gamematch_player_saves_total", "Player rows written by the periodic save.", "counter");
+    _writeSample(oss, "gamematch_player_saves_total", "", static_cast<double>(refPlayer.getSavedWrites()));
+    _writeHeader(oss, "gamematch_player_saves_avoided_total", "Player writes skipped or coalesced.", "counter");
+    _writeSample(oss, "gamematch_player_saves_avoided_total", "", static_cast<double>(refPlayer.getAvoidedWrites()));
+
+	// database
+    _writeHeader(oss, "gamematch_db_flush_seconds", "Duration of a player_battles flush over all shards.", "histogram");
+    _writeHistogram(oss, "gamematch_db_flush_seconds", "", refDb.getFlushHistogram());
+    _writeHeader(oss, "gamematch_db_flushed_rows_total", "player_battles rows written by successful flushes.", "counter");
+    _writeSample(oss, "gamematch_db_flushed_rows_total", "", static_cast<double>(refDb.getFlushedRows()));
+    _writeHeader(oss, "gamematch_db_flush_failures_total", "Failed player_battles flushes.", "counter");
+    _writeSample(oss, "gamematch_db_flush_failures_total", "", static_cast<double>(refDb.getFailedFlushes()));
+
+	// schedule and executor
+    _writeHeader(oss, "gamematch_schedule_runs_total", "Scheduled task callbacks finished.", "counter");
+    _writeSample(oss, "gamematch_schedule_runs_total", "", static_cast<double>(refSchedule.getTaskRuns()));
+    _writeHeader(oss, "gamematch_schedule_overruns_total", "Scheduled task callbacks longer than their interval.", "counter");
+    _writeSample(oss, "gamematch_schedule_overruns_total", "", static_cast<double>(refSchedule.getTaskOverruns()));
+    _writeHeader(oss, "gamematch_schedule_skipped_periods_total", "Fixed-rate periods dropped by the catch-up policy.", "counter");
+    _writeSample(oss, "gamematch_schedule_skipped_periods_total", "", static_cast<double>(refSchedule.getSkippedPeriods()));
+    _writeHeader(oss, "gamematch_schedule_ready_tasks", "Due scheduled tasks waiting for a worker.", "gauge");
+    _writeSample(oss, "gamematch_schedule_ready_tasks", "", static_cast<double>(refSchedule.getReadyTaskCounts()));
+    _writeHeader(oss, "gamematch_schedule_run_seconds", "Duration of scheduled task callbacks.", "histogram");
+    _writeHistogram(oss, "gamematch_schedule_run_seconds", "", refSchedule.getRunTimeHistogram());
+    _writeHeader(oss, "gamematch_schedule_lateness_seconds", "Start of scheduled task callbacks after their due time.", "histogram");
+    _writeHistogram(oss, "gamematch_schedule_lateness_seconds", "", refSchedule.getLatenessHistogram());
+    _writeHeader(oss, "gamematch_executor_tasks_total", "Executor tasks run.", "counter");
+    _writeSample(oss, "gamematch_executor_tasks_total", "", static_cast<double>(refExecutor.getExecutedTasks()));
+    _writeHeader(oss, "gamematch_executor_stolen_tasks_total", "Executor tasks stolen from another worker.", "counter");
+    _writeSample(oss, "gamematch_executor_stolen_tasks_total", "", static_cast<double>(refExecutor.getStolenTasks()));
+    _writeHeader(oss, "gamematch_executor_pending_tasks", "Executor tasks queued and not yet started.", "gauge");
+    _writeSample(oss, "gamematch_executor_pending_tasks", "", static_cast<double>(refExecutor.getPendingTasks()));
+
+	// logger
+    _writeHeader(oss, "gamematch_log_records_total", "Log records written.", "counter");
+    _writeSample(oss, "gamematch_log_records_total", "", static_cast<double>(LogManager::instance().getWrittenRecords()));
+    _writeHeader(oss, "gamematch_log_dropped_total", "Log records dropped on a full ring.", "counter");
+    _writeSample(oss, "gamematch_log_dropped_total", "", static_cast<double>(LogManager::instance().getDroppedRecords()));
+    return oss.str();
+}
@@ -0,0 +1,61 @@
+// metricsManager.h
+#ifndef METRICS_MANAGER_H
+#define METRICS_MANAGER_H
+
+#include <string>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+class LatencyHistogram;
+
+// minimal HTTP server on 127.0.0.1 serving "GET /metrics" in the Prometheus text format (version 0.0.4)
+// the exported values are atomics, gauges and per-thread counters of the managers, a scrape never takes a manager lock
+// one connection at a time on its own thread, "Connection: close" after every response
+class MetricsManager
+{
+public:
+    static MetricsManager& instance();
+
+	// listen on 127.0.0.1:port, false if the port can not be bound
+    bool initialize(uint16_t port);
+    void release();
+
+    bool isRunning() const { return m_running.load(); }
+    uint16_t getPort() const { return m_port; }
+    uint64_t getScrapes() const { return m_scrapes.load(std::memory_order_relaxed); }
+
+	// body of /metrics
+    std::string collectMetrics();
+
+private:
+    MetricsManager();
+    ~MetricsManager();
+
+    MetricsManager(const MetricsManager&) = delete;
+    MetricsManager& operator=(const MetricsManager&) = delete;
+    MetricsManager(MetricsManager&&) = delete;
+    MetricsManager& operator=(MetricsManager&&) = delete;
+
+	// handler for the server thread
+    void serverLoop();
+	// read one request and write the response
+    void _handleConnection(intptr_t clientSocket);
+    static void _closeSocket(intptr_t socketHandle);
+
+	// "# HELP" and "# TYPE" lines of a metric family
+    static void _writeHeader(std::ostringstream& refOss, const char* name, const char* help, const char* type);
+	// one sample, labels like "tier=\"3\"" or empty
+    static void _writeSample(std::ostringstream& refOss, const char* name, const std::string& labels, double value);
+	// _bucket / _sum / _count samples of a histogram in seconds
+    static void _writeHistogram(std::ostringstream& refOss, const char* name, const std::string& labels, const LatencyHistogram& refHistogram);
+
+	intptr_t m_listenSocket = -1;       // SOCKET on windows, file descriptor elsewhere
+	uint16_t m_port = 0;
+	std::thread m_serverThread;
+	std::atomic<bool> m_running = false;
+	std::atomic<uint64_t> m_scrapes = 0;
+};
+
+#endif // METRICS_MANAGER_H
@@ -3,8 +3,9 @@
 // @author: August
 // @date  : 2025-05-15
 #include "playerManager.h"
-#include "dbManager.h"
 #include "battleManager.h"
+#include "journalManager.h"
+#include "traceManager.h"
 #include "../../utils/utils.h"
 #include "../../include/globalDefine.h"
 #include <iostream>
@@ -32,6 +33,8 @@ bool PlayerManager::initialize()
     m_mapPlayers.clear();
     m_setOnlinePlayerIds.clear();
     m_setDirtyPlayerIds.clear();
+    m_onlinePlayerCounts.store(0);
+    m_dirtyPlayerCounts.store(0);
 
     std::cout << "[PlayerManager] : initialized!" << std::endl;
     return true;
@@ -40,8 +43,8 @@ bool PlayerManager::initialize()
 void PlayerManager::release()
 {
     // lock all mutexes in automatic mode to avoid deadlock
-    std::unique_lock<std::mutex> lockMapPlayers(m_mapPlayersMutex, std::defer_lock);
-    std::unique_lock<std::mutex> lockSetdirtyPlayerIds(m_setdirtyPlayerIdsMutex, std::defer_lock);
+    std::unique_lock<ProfiledMutex> lockMapPlayers(m_mapPlayersMutex, std::defer_lock);
+    std::unique_lock<ProfiledMutex> lockSetdirtyPlayerIds(m_setdirtyPlayerIdsMutex, std::defer_lock);
 
 	std::lock(lockMapPlayers, lockSetdirtyPlayerIds);   // lock all at once
     
@@ -49,17 +52,79 @@ void PlayerManager::release()
     m_setOnlinePlayerIds.clear();
     m_mapPlayers.clear();
 	m_setDirtyPlayerIds.clear();
+    m_onlinePlayerCounts.store(0);
+    m_dirtyPlayerCounts.store(0);
+    if (m_uPlayerStore)
+    {
+        m_uPlayerStore->close();
+        m_uPlayerStore.reset();
+    }
     std::cout << "[PlayerManager] : released!" << std::endl;
 }
 
+void PlayerManager::setPlayerStore(std::unique_ptr<PlayerStore> uPlayerStore)
+{
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+    m_uPlayerStore = std::move(uPlayerStore);
+}
+
+void PlayerManager::preloadPlayers(const std::vector<uint64_t>& refVecIds)
+{
+    std::vector<uint64_t> vecMissingIds;
+    {
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+        if (!m_uPlayerStore)
+        {
+            return;
+        }
+        for (uint64_t id : refVecIds)
+        {
+            if (id != 0 && !_getPlayerNoLock(id))
+            {
+                vecMissingIds.emplace_back(id);
+            }
+        }
+    }
+    if (vecMissingIds.empty())
+    {
+        return;
+    }
+
+	// query without the map lock, players loaded by others in the meantime are kept
+    std::vector<PlayerRecord> vecRecords;
+    m_uPlayerStore->loadMany(vecMissingIds, vecRecords);
+
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+    for (const auto& record : vecRecords)
+    {
+        _syncPlayerNoLock(record.m_id, record.m_score, record.m_wins, record.m_updatedTime);
+    }
+}
+
 Player* PlayerManager::playerLogin(uint64_t id)
 {
-    std::lock_guard<std::mutex> lock(m_mapPlayersMutex);
+    PlayerStore* pPlayerStore = nullptr;
+    {
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+        if (!m_uPlayerStore)
+        {
+            return nullptr;
+        }
+        if (id != 0 && _getPlayerNoLock(id))
+        {
+            return _loginPlayerNoLock(id);
+        }
+        pPlayerStore = m_uPlayerStore.get();
+    }
 
+	// insert or load without the map lock, a slow store does not stall the battles and other logins
+    PlayerRecord record;
+    bool isLoaded = false;
     if (id == 0)
     {
-		// insert new player
-        id = DbManager::instance().insertPlayerBattles();
+		// insert new player, the row is stamped with the exact wall clock like every db update
+        record = PlayerRecord{ 0, 0, 0, time_utils::getTimestampMS() };
+        id = pPlayerStore->insert(record);
         if (id == 0)
         {
             std::cerr << "[ERROR] "
@@ -69,8 +134,25 @@ Player* PlayerManager::playerLogin(uint64_t id)
                 << std::endl;
 			return nullptr;
         }
+        isLoaded = true;
+    }
+    else
+    {
+		// not loaded yet, try the store
+        isLoaded = pPlayerStore->loadOne(id, record);
     }
 
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+    if (isLoaded)
+    {
+		// a player loaded by another login in the meantime is kept
+        _syncPlayerNoLock(record.m_id, record.m_score, record.m_wins, record.m_updatedTime);
+    }
+    return _loginPlayerNoLock(id);
+}
+
+Player* PlayerManager::_loginPlayerNoLock(uint64_t id)
+{
     Player* pPlayer = _getPlayerNoLock(id);
     if (!pPlayer)
     {
@@ -86,12 +168,13 @@ Player* PlayerManager::playerLogin(uint64_t id)
     {
         pPlayer->setStatus(common::PlayerStatus::lobby);
     }
+    m_logins.add();
     return pPlayer;
 }
 
 bool PlayerManager::playerLogout(uint64_t id)
 {
-    std::lock_guard<std::mutex> lock(m_mapPlayersMutex);
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
 
     Player* pPlayer = _getPlayerNoLock(id);
     if (!pPlayer)
@@ -108,14 +191,14 @@ bool PlayerManager::playerLogout(uint64_t id)
 
 bool PlayerManager::isPlayerOnline(uint64_t id)
 {
-    std::lock_guard<std::mutex> lock(m_mapPlayersMutex);
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
 
     return (m_setOnlinePlayerIds.find(id) != m_setOnlinePlayerIds.end());
 }
 
 Player* PlayerManager::getPlayer(uint64_t id)
 {
-	std::lock_guard<std::mutex> lock(m_mapPlayersMutex);
+	std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
 	Player* pPlayer = _getPlayerNoLock(id);
     if (!pPlayer)
     {
@@ -127,7 +210,7 @@ Player* PlayerManager::getPlayer(uint64_t id)
 
 std::vector<Player*> PlayerManager::getOnlinePlayers() 
 {
-    std::lock_guard<std::mutex> lock(m_mapPlayersMutex);
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
 
     std::vector<Player*> tmpVecPlayers;
     for (auto& id : m_setOnlinePlayerIds) 
@@ -142,12 +225,133 @@ std::vector<Player*> PlayerManager::getOnlinePlayers()
     return tmpVecPlayers;
 }
 
+std::vector<Player*> PlayerManager::getTopPlayers(size_t counts)
+{
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+
+    std::vector<Player*> tmpVecPlayers;
+    tmpVecPlayers.reserve(m_mapPlayers.size());
+    for (const auto& pair : m_mapPlayers)
+    {
+        tmpVecPlayers.push_back(pair.second.get());
+    }
+
+	// sorting rules:
+	// 1. score (descending)
+	// 2. wins (descending)
+	// 3. id (ascending)
+    std::sort(tmpVecPlayers.begin(), tmpVecPlayers.end(), [](const Player* a, const Player* b) {
+        if (a->getScore() != b->getScore())
+        {
+            return a->getScore() > b->getScore();
+        }
+        if (a->getWins() != b->getWins())
+        {
+            return a->getWins() > b->getWins();
+        }
+        return a->getId() < b->getId();
+        });
+    if (tmpVecPlayers.size() > counts)
+    {
+        tmpVecPlayers.resize(counts);
+    }
+    return tmpVecPlayers;
+}
+
 // *** only for dbManager to sync player data from db ***
 void PlayerManager::syncPlayerFromDbNoLock(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime)
 {
 	_syncPlayerNoLock(id, score, wins, updatedTime);
 }
 
+// *** only for dbManager to reserve buckets before a bulk load ***
+void PlayerManager::reservePlayersNoLock(size_t counts)
+{
+    m_mapPlayers.reserve(m_mapPlayers.size() + counts);
+}
+
+// *** only for dbManager to drop players loaded from a stale snapshot ***
+void PlayerManager::clearPlayersNoLock()
+{
+    m_mapPlayers.clear();
+}
+
+// *** only for dbManager to merge a partition loaded by a loader thread ***
+void PlayerManager::mergePlayersFromDbNoLock(std::vector<std::unique_ptr<Player>>& refVecPartition)
+{
+    for (auto& uPlayer : refVecPartition)
+    {
+        if (!uPlayer)
+        {
+            continue;
+        }
+        const uint64_t id = uPlayer->getId();
+        m_mapPlayers.try_emplace(id, std::move(uPlayer));
+    }
+    refVecPartition.clear();
+}
+
+// *** only for dbManager to replay rows newer than the snapshot, overwrite the existing player ***
+void PlayerManager::replayPlayerFromDbNoLock(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime)
+{
+    Player* pPlayer = _getPlayerNoLock(id);
+    if (!pPlayer)
+    {
+        _syncPlayerNoLock(id, score, wins, updatedTime);
+        return;
+    }
+    pPlayer->syncBattleData(score, wins, updatedTime);
+}
+
+// *** only for journalManager to replay battle results at startup ***
+void PlayerManager::replayPlayerFromJournal(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime)
+{
+    {
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+        replayPlayerFromDbNoLock(id, score, wins, updatedTime);
+        Player* pPlayer = _getPlayerNoLock(id);
+        if (pPlayer)
+        {
+			// the journaled data is not in db yet, keep the time of the battle
+            pPlayer->markDirty(common::PlayerDirtyField::DirtyPersisted, updatedTime);
+        }
+    }
+    enqueuePlayerSave(id);
+}
+
+// copy battle data of all players
+void PlayerManager::getPlayerRecords(std::vector<PlayerRecord>& refVecRecords)
+{
+    std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+
+    refVecRecords.clear();
+    refVecRecords.reserve(m_mapPlayers.size());
+    for (const auto& itPlayer : m_mapPlayers)
+    {
+        const Player* pPlayer = itPlayer.second.get();
+        if (!pPlayer)
+        {
+            continue;
+        }
+        refVecRecords.push_back({ pPlayer->getId(), pPlayer->getScore(), pPlayer->getWins(), pPlayer->getUpdatedTime() });
+    }
+}
+
+void PlayerManager::getPlayerIds(std::vector<uint64_t>& refVecIds)
+{
+    {
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+
+        refVecIds.clear();
+        refVecIds.reserve(m_mapPlayers.size());
+        for (const auto& itPlayer : m_mapPlayers)
+        {
+            refVecIds.emplace_back(itPlayer.first);
+        }
+    }
+    std::sort(refVecIds.begin(), refVecIds.end());
+}
+
 Player* PlayerManager::_getPlayerNoLock(uint64_t id)
 {
     if (m_mapPlayers.empty())
@@ -172,6 +376,7 @@ void PlayerManager::_setPlayerOnlineNoLock(uint64_t id, bool isOnline)
     {
         m_setOnlinePlayerIds.erase(id);
     }
+    m_onlinePlayerCounts.store(m_setOnlinePlayerIds.size(), std::memory_order_relaxed);
 }
 
 void PlayerManager::_syncPlayerNoLock(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime)
@@ -185,55 +390,135 @@ void PlayerManager::_syncPlayerNoLock(uint64_t id, uint32_t score, uint32_t wins
     m_mapPlayers[id] = std::move(uPlayer);
 }
 
+// the result is journaled without waiting, the caller waits once for all players of a battle (JournalManager::callWhenDurable)
 void PlayerManager::handlePlayerBattleResult(uint64_t playerId, uint32_t scoreDelta, bool isWin)
 {
+    m_battleResults.add();
     {
-        std::lock_guard<std::mutex> lock(m_mapPlayersMutex);
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
 
         Player* pPlayer = _getPlayerNoLock(playerId);
         if (!pPlayer)
         {
             return;
         }
-        if (isWin)
-        {
-            pPlayer->addWins();
-            pPlayer->addScore(scoreDelta);
-        }
-        else
-        {
-            pPlayer->subScore(scoreDelta);
-        }
+        pPlayer->applyBattleResult(scoreDelta, isWin);
         pPlayer->setStatus(common::PlayerStatus::lobby);
+
+		// mark dirty before journaling, so a checkpoint never removes a record whose player is not flushed yet
+        enqueuePlayerSave(playerId);
+        JournalManager::instance().appendNoWait(playerId, pPlayer->getScore(), pPlayer->getWins());
     }
-    enqueuePlayerSave(playerId);
 }
 
 void PlayerManager::enqueuePlayerSave(uint64_t playerId)
 {
-	std::lock_guard<std::mutex> lock(m_setdirtyPlayerIdsMutex);
+	std::lock_guard<ProfiledMutex> lock(m_setdirtyPlayerIdsMutex);
 	m_setDirtyPlayerIds.emplace(playerId);
+    m_dirtyPlayerCounts.store(m_setDirtyPlayerIds.size(), std::memory_order_relaxed);
 }
 
-void PlayerManager::saveDirtyPlayers()
+// save dirty players into db, returns false if any player failed to save
+bool PlayerManager::saveDirtyPlayers()
 {
+    TRACE_SPAN("PlayerManager::saveDirtyPlayers");
     if (m_setDirtyPlayerIds.empty())
     {
-        return;
+        return true;
     }
+	// journal records up to this sequence belong to players already in the dirty set
+    const uint64_t journalSeq = JournalManager::instance().getLastSeq();
     std::set<uint64_t> tmpSetSaveIds;
     {
 		// lock m_setDirtyPlayerIds
-        std::lock_guard<std::mutex> lock(m_setdirtyPlayerIdsMutex);
+        std::lock_guard<ProfiledMutex> lock(m_setdirtyPlayerIdsMutex);
 		tmpSetSaveIds.swap(m_setDirtyPlayerIds);    // save the ids to tmpSetSaveIds and clear m_setDirtyPlayerIds
+        m_dirtyPlayerCounts.store(m_setDirtyPlayerIds.size(), std::memory_order_relaxed);
     }
-    for (auto& id : tmpSetSaveIds)
+    std::vector<PlayerRecordUpdate> vecUpdates;
+    std::vector<uint32_t> vecVersions;
+    vecUpdates.reserve(tmpSetSaveIds.size());
+    vecVersions.reserve(tmpSetSaveIds.size());
+    uint64_t avoidedWrites = 0;
+	uint64_t coalescedWrites = 0;   // counted only once the write succeeded, a failed write is coalesced again by the retry
     {
-		Player* pPlayer = _getPlayerNoLock(id);
-        if (!pPlayer)
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+        if (!m_uPlayerStore)
         {
-            continue;
+            return false;
+        }
+        for (auto& id : tmpSetSaveIds)
+        {
+            Player* pPlayer = _getPlayerNoLock(id);
+            if (!pPlayer)
+            {
+                continue;
+            }
+            const uint8_t dirtyMask = pPlayer->takePersistedDirty();
+            if (dirtyMask == common::PlayerDirtyField::DirtyNone)
+            {
+				// only status changed (e.g. logout), nothing to write
+                avoidedWrites++;
+                continue;
+            }
+			// all changes since the last save are coalesced into this write
+            const uint32_t version = pPlayer->getVersion();
+            if (version > pPlayer->getSavedVersion())
+            {
+                coalescedWrites += (version - pPlayer->getSavedVersion()) - 1;
+            }
+
+            PlayerRecordUpdate update;
+            update.m_record = { pPlayer->getId(), pPlayer->getScore(), pPlayer->getWins(), pPlayer->getUpdatedTime() };
+            update.m_dirtyMask = dirtyMask;
+            vecUpdates.emplace_back(update);
+            vecVersions.emplace_back(version);
         }
-        DbManager::instance().updatePlayerBattles(pPlayer->getId(), pPlayer->getScore(), pPlayer->getWins());
     }
-}
\ No newline at end of file
+    m_avoidedWrites += avoidedWrites;
+    if (vecUpdates.empty())
+    {
+        JournalManager::instance().checkpoint(journalSeq);
+        return true;
+    }
+
+	// write outside the player lock, logins and battle results are not blocked by disk I/O
+    const bool isAllSaved = m_uPlayerStore->batchUpdate(vecUpdates);
+    {
+        std::lock_guard<ProfiledMutex> lock(m_mapPlayersMutex);
+        for (size_t i = 0; i < vecUpdates.size(); i++)
+        {
+            Player* pPlayer = _getPlayerNoLock(vecUpdates[i].m_record.m_id);
+            if (!pPlayer)
+            {
+                continue;
+            }
+            if (isAllSaved)
+            {
+                pPlayer->markSaved(vecVersions[i]);
+            }
+            else
+            {
+                pPlayer->restoreDirty(vecUpdates[i].m_dirtyMask);
+            }
+        }
+    }
+    if (isAllSaved)
+    {
+        m_savedWrites += vecUpdates.size();
+        m_avoidedWrites += coalescedWrites;
+		// the journal records are compacted into player_battles
+        JournalManager::instance().checkpoint(journalSeq);
+    }
+    else
+    {
+		// keep them dirty, retry on the next save
+        std::lock_guard<ProfiledMutex> lock(m_setdirtyPlayerIdsMutex);
+        for (const auto& update : vecUpdates)
+        {
+            m_setDirtyPlayerIds.emplace(update.m_record.m_id);
+        }
+        m_dirtyPlayerCounts.store(m_setDirtyPlayerIds.size(), std::memory_order_relaxed);
+    }
+    return isAllSaved;
+}
@@ -2,9 +2,15 @@
 #ifndef PLAYER_MANAGER_H
 #define PLAYER_MANAGER_H
 #include "../objects/player.h"
+#include "../stores/playerStore.h"
+#include "../../utils/counter.h"
+#include "../../utils/profiledMutex.h"
 #include <unordered_map>
 #include <set>
+#include <vector>
+#include <memory>
 #include <mutex>
+#include <atomic>
 #include <cstdint>
 
 class PlayerManager
@@ -15,19 +21,43 @@ public:
 
     bool initialize();
     void release();
+
+	// storage backend chosen at startup, PlayerManager owns it
+    void setPlayerStore(std::unique_ptr<PlayerStore> uPlayerStore);
+    PlayerStore* getPlayerStore() { return m_uPlayerStore.get(); }
+	// load the players not in memory yet with one store query, so the following logins skip the store
+    void preloadPlayers(const std::vector<uint64_t>& refVecIds);
     Player* playerLogin(uint64_t id);
     bool playerLogout(uint64_t id);
     bool isPlayerOnline(uint64_t id);
     Player* getPlayer(uint64_t id);
     std::vector<Player*> getOnlinePlayers();
+	// the first counts players of the ranking (score desc, wins desc, id asc)
+    std::vector<Player*> getTopPlayers(size_t counts);
 	std::unordered_map<uint64_t, std::unique_ptr<Player>>* getAllPlayers() { return &m_mapPlayers; }
     std::set<uint64_t>* getOnlinePlayerIds() { return &m_setOnlinePlayerIds; }
     void syncPlayerFromDbNoLock(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime);
+    void reservePlayersNoLock(size_t counts);
+    void clearPlayersNoLock();
+    void mergePlayersFromDbNoLock(std::vector<std::unique_ptr<Player>>& refVecPartition);
+    void replayPlayerFromDbNoLock(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime);
+    void getPlayerRecords(std::vector<PlayerRecord>& refVecRecords);
+	// ids of the loaded players, ascending
+    void getPlayerIds(std::vector<uint64_t>& refVecIds);
+    void replayPlayerFromJournal(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime);
 
     void handlePlayerBattleResult(uint64_t playerId, uint32_t scoreDelta, bool isWin);
 
     void enqueuePlayerSave(uint64_t playerId);
-    void saveDirtyPlayers();
+    bool saveDirtyPlayers();
+    uint64_t getSavedWrites() const { return m_savedWrites.load(); }
+    uint64_t getAvoidedWrites() const { return m_avoidedWrites.load(); }
+
+	// gauges and counters read without the player locks (metrics)
+    uint64_t getOnlinePlayerCounts() const { return m_onlinePlayerCounts.load(std::memory_order_relaxed); }
+    uint64_t getDirtyPlayerCounts() const { return m_dirtyPlayerCounts.load(std::memory_order_relaxed); }
+    uint64_t getLogins() const { return m_logins.get(); }
+    uint64_t getBattleResults() const { return m_battleResults.get(); }
 
 private:
 
@@ -43,13 +73,24 @@ private:
     Player* _getPlayerNoLock(uint64_t id);
     void _setPlayerOnlineNoLock(uint64_t id, bool isOnline);
     void _syncPlayerNoLock(uint64_t id, uint32_t score, uint32_t wins, uint64_t updatedTime);
+	// mark a loaded player online, nullptr if not loaded
+    Player* _loginPlayerNoLock(uint64_t id);
+
+    std::unique_ptr<PlayerStore> m_uPlayerStore{};
 
     std::unordered_map<uint64_t/* playerId */, std::unique_ptr<Player>> m_mapPlayers{};
 	std::set<uint64_t/* playerId */> m_setOnlinePlayerIds{};
-	std::mutex m_mapPlayersMutex;   // lock for m_mapPlayers
+	ProfiledMutex m_mapPlayersMutex{ "PlayerManager::m_mapPlayersMutex" };  // lock for m_mapPlayers
 
     std::set<uint64_t/* playerId */> m_setDirtyPlayerIds{};
-	std::mutex m_setdirtyPlayerIdsMutex;    // lock for m_setDirtyPlayerIds
+	ProfiledMutex m_setdirtyPlayerIdsMutex{ "PlayerManager::m_setdirtyPlayerIdsMutex" };    // lock for m_setDirtyPlayerIds
+
+	std::atomic<uint64_t> m_savedWrites = 0;    // player rows written by saveDirtyPlayers
+	std::atomic<uint64_t> m_avoidedWrites = 0;  // writes skipped (no persisted change) or coalesced into one write
+	std::atomic<uint64_t> m_onlinePlayerCounts = 0; // size of m_setOnlinePlayerIds
+	std::atomic<uint64_t> m_dirtyPlayerCounts = 0;  // size of m_setDirtyPlayerIds
+	ShardedCounter m_logins;
+	ShardedCounter m_battleResults;
 };
 
 #endif // !PLAYER_MANAGER_H
\ No newline at end of file
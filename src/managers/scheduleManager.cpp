@@ -4,21 +4,77 @@
 // @date  : 2025-05-16
 #include "ScheduleManager.h"
 #include "PlayerManager.h"
+#include "snapshotManager.h"
+#include "dbManager.h"
+#include "executorManager.h"
+#include "clockManager.h"
+#include "traceManager.h"
+#include <algorithm>
+
+// two, so a slow snapshot cannot hold back the player flush; a task is requeued only after it returns, so save_players never overlaps itself
+const uint32_t SCHEDULE_LONG_RUNNING_THREADS = 2;           // workers for long-running tasks
+const int64_t SCHEDULE_MAX_CATCH_UP_RUNS = 8;               // CatchUpBurst runs at most this many missed periods
 
 bool ScheduleManager::initialize()
 {
+	// short tasks run on the shared executor
+    if (!ExecutorManager::instance().isRunning())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "ExecutorManager is not running."
+            << std::endl;
+        return false;
+    }
+
 	// register a task to save player data every 5 seconds
+    ScheduleOptions saveOptions;
+    saveOptions.m_name = "save_players";
+    saveOptions.m_priority = schedule::TaskPriority::TaskPriorityHigh;
+    saveOptions.m_isLongRunning = true;
     registerTask(
         []()
         {
             PlayerManager::instance().saveDirtyPlayers();
         },
-        5
+        std::chrono::seconds(5),
+        saveOptions
+    );
+
+	// register a task to write the player snapshot every 60 seconds
+    ScheduleOptions snapshotOptions;
+    snapshotOptions.m_name = "write_snapshot";
+    snapshotOptions.m_isLongRunning = true;
+    registerTask(
+        []()
+        {
+            SnapshotManager::instance().writeSnapshot();
+        },
+        std::chrono::seconds(60),
+        snapshotOptions
+    );
+
+	// register a task to back up the database every hour, the copy runs on its own thread
+    ScheduleOptions backupOptions;
+    backupOptions.m_name = "db_backup";
+    backupOptions.m_priority = schedule::TaskPriority::TaskPriorityLow;
+    registerTask(
+        []()
+        {
+            DbManager::instance().startBackup();
+        },
+        std::chrono::seconds(3600),
+        backupOptions
     );
 
-	// start the worker thread
+	// start the timer and long-running worker threads
     m_running = true;
     m_workerThread = std::thread(&ScheduleManager::workerLoop, this);
+    for (uint32_t i = 0; i < SCHEDULE_LONG_RUNNING_THREADS; i++)
+    {
+        m_vecWorkerThreads.emplace_back(&ScheduleManager::longRunningWorkerLoop, this);
+    }
 
     std::cout << "[ScheduleManager] : initialized!" << std::endl;
     return true;
@@ -28,27 +84,151 @@ void ScheduleManager::release()
 {
     if (m_running)
     {
-        m_running = false;
+        {
+            std::lock_guard<ProfiledMutex> lock(m_mutex);
+            m_running = false;
+            ClockManager::instance().notifyAll(m_cvTasks);
+        }
+        m_cvLongRunning.notify_all();
         if (m_workerThread.joinable())
         {
 			// wait for the worker thread to finish its work and exit
             m_workerThread.join();
         }
+        for (auto& worker : m_vecWorkerThreads)
+        {
+            if (worker.joinable())
+            {
+				// wait for the running callbacks, tasks still waiting in the ready queues are dropped
+                worker.join();
+            }
+        }
+        m_vecWorkerThreads.clear();
+
+		// wait for the short tasks running on the executor
+        std::unique_lock<ProfiledMutex> lock(m_mutex);
+        m_mutex.waitNative([this](std::unique_lock<std::mutex>& refNativeLock) { m_cvIdle.wait(refNativeLock, [this]() { return m_runningShortTasks == 0; }); });
     }
 	// lock after thread finished
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_vecTasks.clear();
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
+    m_mapTasks.clear();
+    m_setTimers.clear();
+    m_queReadyTasks = {};
+    m_queLongRunningTasks = {};
+    m_readyTaskCounts.store(0);
     std::cout << "[ScheduleManager] : released!" << std::endl;
 }
 
 // register a new task with a callback function and interval
-void ScheduleManager::registerTask(std::function<void()> funcCallback, int intervalSeconds, bool m_isRepeating)
+ScheduledTaskHandle ScheduleManager::registerTask(std::function<void()> funcCallback, std::chrono::steady_clock::duration interval, const ScheduleOptions& options)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
+
+    const uint64_t taskId = m_nextTaskId++;
+    ScheduledTask& refTask = m_mapTasks[taskId];
+    refTask.m_taskId = taskId;
+    refTask.m_funcCallback = std::move(funcCallback);
+	refTask.m_interval = std::max<std::chrono::steady_clock::duration>(interval, std::chrono::milliseconds(1));    // a zero interval would spin
+    refTask.m_options = options;
+    _addTimerNoLock(refTask, ClockManager::instance().now() + refTask.m_interval);
+    return ScheduledTaskHandle(taskId);
+}
+
+ScheduledTaskHandle ScheduleManager::registerTask(std::function<void()> funcCallback, int intervalSeconds, bool m_isRepeating,
+    schedule::TaskPriority priority, bool isLongRunning)
+{
+    ScheduleOptions options;
+    options.m_isRepeating = m_isRepeating;
+    options.m_priority = priority;
+    options.m_isLongRunning = isLongRunning;
 
     // Converts the integer 'intervalSeconds' into a std::chrono::seconds duration object.
     // This provides type safety and clarity for time units.
-    m_vecTasks.emplace_back(funcCallback, std::chrono::seconds(intervalSeconds), m_isRepeating);
+    return registerTask(std::move(funcCallback), std::chrono::seconds(intervalSeconds), options);
+}
+
+bool ScheduleManager::isTaskActive(uint64_t taskId)
+{
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
+    return m_mapTasks.count(taskId) > 0;
+}
+
+bool ScheduleManager::cancelTask(uint64_t taskId)
+{
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
+
+    auto itTask = m_mapTasks.find(taskId);
+    if (itTask == m_mapTasks.end())
+    {
+        return false;
+    }
+	// a ready queue entry of the task is skipped by the worker, a running callback is not rescheduled
+    m_setTimers.erase(TimerKey(itTask->second.m_nextExecutionTime, taskId));
+    m_mapTasks.erase(itTask);
+    return true;
+}
+
+bool ScheduleManager::rescheduleTask(uint64_t taskId, std::chrono::steady_clock::duration interval)
+{
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
+
+    auto itTask = m_mapTasks.find(taskId);
+    if (itTask == m_mapTasks.end())
+    {
+        return false;
+    }
+    ScheduledTask& refTask = itTask->second;
+    refTask.m_interval = std::max<std::chrono::steady_clock::duration>(interval, std::chrono::milliseconds(1));
+    if (m_setTimers.erase(TimerKey(refTask.m_nextExecutionTime, taskId)) > 0)
+    {
+        _addTimerNoLock(refTask, ClockManager::instance().now() + refTask.m_interval);
+    }
+	// a ready or running task picks up the new interval when it is rescheduled
+    return true;
+}
+
+void ScheduleManager::getTaskStats(std::vector<ScheduledTaskStats>& refVecStats)
+{
+    refVecStats.clear();
+
+    std::lock_guard<ProfiledMutex> lock(m_mutex);
+    refVecStats.reserve(m_mapTasks.size());
+    for (const auto& itTask : m_mapTasks)
+    {
+        const ScheduledTask& refTask = itTask.second;
+        ScheduledTaskStats stats;
+        stats.m_taskId = refTask.m_taskId;
+        stats.m_name = refTask.m_options.m_name.empty() ? ("task" + std::to_string(refTask.m_taskId)) : refTask.m_options.m_name;
+        stats.m_interval = refTask.m_interval;
+        stats.m_isLongRunning = refTask.m_options.m_isLongRunning;
+        stats.m_isRunning = refTask.m_isRunning;
+        stats.m_runs = refTask.m_runs;
+        stats.m_overruns = refTask.m_overruns;
+        stats.m_skippedPeriods = refTask.m_skippedPeriods;
+        stats.m_runTimeP50Us = refTask.m_runTimeHistogram.getPercentile(50.0);
+        stats.m_runTimeP99Us = refTask.m_runTimeHistogram.getPercentile(99.0);
+        stats.m_runTimeMaxUs = refTask.m_runTimeHistogram.getMax();
+        stats.m_latenessMeanUs = refTask.m_latenessHistogram.getMean();
+        stats.m_latenessP99Us = refTask.m_latenessHistogram.getPercentile(99.0);
+        stats.m_latenessMaxUs = refTask.m_latenessHistogram.getMax();
+        refVecStats.emplace_back(stats);
+    }
+    std::sort(refVecStats.begin(), refVecStats.end(), [](const ScheduledTaskStats& lhs, const ScheduledTaskStats& rhs)
+        {
+            return lhs.m_taskId < rhs.m_taskId;
+        });
+}
+
+void ScheduleManager::_addTimerNoLock(ScheduledTask& refTask, std::chrono::steady_clock::time_point nextExecutionTime)
+{
+    refTask.m_nextExecutionTime = nextExecutionTime;
+    const bool isEarliest = m_setTimers.empty() || (nextExecutionTime < m_setTimers.begin()->first);
+    m_setTimers.emplace(nextExecutionTime, refTask.m_taskId);
+    if (isEarliest)
+    {
+		// the timer is waiting for a later task
+        ClockManager::instance().notifyAll(m_cvTasks);
+    }
 }
 
 ScheduleManager::ScheduleManager()
@@ -59,42 +239,216 @@ ScheduleManager::~ScheduleManager()
 {
 }
 
-// handler for the worker thread
+// handler for the timer thread
+// sleeps until the earliest task is due (or a task is registered), then hands due tasks to the workers
 void ScheduleManager::workerLoop()
 {
+    TraceManager::setThreadName("schedule timer");
+    ClockManager& refClock = ClockManager::instance();
+	refClock.attachThread();    // virtual time waits for the timer to hand out the due tasks
+
+    std::unique_lock<ProfiledMutex> lock(m_mutex);
     while (m_running)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_setTimers.empty())
+        {
+            m_mutex.waitNative([this, &refClock](std::unique_lock<std::mutex>& refNativeLock) { refClock.waitUntil(refNativeLock, m_cvTasks, ClockManager::TimePoint::max()); });
+            continue;
+        }
 
-		auto now = std::chrono::steady_clock::now();    // get current time point
+		auto now = refClock.now();  // get current time point
+        if (m_setTimers.begin()->first > now)
+        {
+			// woken up early by a new task or release, the earliest timer is checked again
+            const auto wakeTime = m_setTimers.begin()->first;
+            m_mutex.waitNative([this, &refClock, wakeTime](std::unique_lock<std::mutex>& refNativeLock) { refClock.waitUntil(refNativeLock, m_cvTasks, wakeTime); });
+            continue;
+        }
 
-		// loop through the tasks and check if they need
-        for (auto it = m_vecTasks.begin(); it != m_vecTasks.end(); )
+		// move all due tasks to the ready queues
+        uint32_t readyTaskCounts = 0;
+        bool hasLongRunningTasks = false;
+        while (!m_setTimers.empty() && m_setTimers.begin()->first <= now)
         {
-			// check if the task is due (current time - last execution time >= task interval)
-            if ((now - it->m_lastExecutionTime) >= it->m_interval)
+            ScheduledTask& refTask = m_mapTasks[m_setTimers.begin()->second];
+            m_setTimers.erase(m_setTimers.begin());
+
+            ReadyTask readyTask;
+            readyTask.m_priority = refTask.m_options.m_priority;
+            readyTask.m_dueTime = refTask.m_nextExecutionTime;
+            readyTask.m_taskId = refTask.m_taskId;
+            if (refTask.m_options.m_isLongRunning)
             {
-				it->m_funcCallback();   // execute the task callback function
-
-				it->m_lastExecutionTime = now;  // update the last execution time
-
-                if (!it->m_isRepeating)
-                {
-					// if it's a one-time task, remove it from the list
-                    it = m_vecTasks.erase(it);
-                }
-                else
-                {
-					// if it's a repeating task, just move to the next task
-                    ++it;
-                }
+                m_queLongRunningTasks.emplace(readyTask);
+                m_readyTaskCounts.fetch_add(1, std::memory_order_relaxed);
+				refClock.beginWork();   // ended by the long-running worker
+                hasLongRunningTasks = true;
             }
             else
             {
-				// if the task is not due, just move to the next task
-                ++it;
+                m_queReadyTasks.emplace(readyTask);
+                m_readyTaskCounts.fetch_add(1, std::memory_order_relaxed);
+                readyTaskCounts++;
             }
         }
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));  // wait 1ms before checking again
+		// one executor job per ready task, each job runs the ready task with the highest priority at that time
+        for (uint32_t i = 0; i < readyTaskCounts; i++)
+        {
+            ExecutorManager::instance().submit([this]() { this->runShortTask(); });
+        }
+        if (hasLongRunningTasks)
+        {
+            m_cvLongRunning.notify_all();
+        }
+    }
+    lock.unlock();
+    refClock.detachThread();
+}
+
+// handler for the long-running worker threads
+void ScheduleManager::longRunningWorkerLoop()
+{
+    TraceManager::setThreadName("schedule long-running");
+    std::unique_lock<ProfiledMutex> lock(m_mutex);
+    while (true)
+    {
+        m_mutex.waitNative([this](std::unique_lock<std::mutex>& refNativeLock) { m_cvLongRunning.wait(refNativeLock, [this]() { return !m_queLongRunningTasks.empty() || !m_running; }); });
+        if (!m_running)
+        {
+            break;
+        }
+        _runReadyTask(lock, m_queLongRunningTasks);
+        ClockManager::instance().endWork();
     }
-}
\ No newline at end of file
+}
+
+// executor job for one ready short task
+void ScheduleManager::runShortTask()
+{
+    std::unique_lock<ProfiledMutex> lock(m_mutex);
+    if (!m_running || m_queReadyTasks.empty())
+    {
+        return;
+    }
+    m_runningShortTasks++;
+    _runReadyTask(lock, m_queReadyTasks);
+    m_runningShortTasks--;
+    if (!m_running && m_runningShortTasks == 0)
+    {
+        m_cvIdle.notify_all();
+    }
+}
+
+// run the ready task with the highest priority without the lock, then reschedule it
+void ScheduleManager::_runReadyTask(std::unique_lock<ProfiledMutex>& refLock, ReadyTaskQueue& refQueue)
+{
+    const uint64_t taskId = refQueue.top().m_taskId;
+    const auto dueTime = refQueue.top().m_dueTime;
+    refQueue.pop();
+    m_readyTaskCounts.fetch_sub(1, std::memory_order_relaxed);
+
+    auto itTask = m_mapTasks.find(taskId);
+    if (itTask == m_mapTasks.end())
+    {
+		// cancelled after it became due
+        return;
+    }
+    itTask->second.m_isRunning = true;
+    std::function<void()> funcCallback = itTask->second.m_funcCallback;
+
+    refLock.unlock();
+    const auto startTime = ClockManager::instance().now();
+	funcCallback();  // execute the task callback function (registerTask, cancel can be called meanwhile)
+    const auto finishTime = ClockManager::instance().now();
+    const uint64_t runTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(finishTime - startTime).count();
+    const uint64_t latenessUs = std::chrono::duration_cast<std::chrono::microseconds>(std::max(startTime - dueTime, std::chrono::steady_clock::duration::zero())).count();
+    m_taskRuns.add();
+    m_runTimeHistogram.record(runTimeUs);
+    m_latenessHistogram.record(latenessUs);
+    refLock.lock();
+
+	// look up again, the task may be cancelled during the callback
+    itTask = m_mapTasks.find(taskId);
+    if (itTask == m_mapTasks.end())
+    {
+        return;
+    }
+    ScheduledTask& refTask = itTask->second;
+    refTask.m_isRunning = false;
+    refTask.m_runs++;
+    refTask.m_runTimeHistogram.record(runTimeUs);
+    refTask.m_latenessHistogram.record(latenessUs);
+    if (finishTime - startTime > refTask.m_interval)
+    {
+        refTask.m_overruns++;
+        m_taskOverruns.add();
+    }
+    if (refTask.m_options.m_isRepeating && m_running)
+    {
+        _rescheduleNoLock(refTask, finishTime);
+    }
+    else
+    {
+		// if it's a one-time task, just drop it
+        m_mapTasks.erase(itTask);
+    }
+}
+
+void ScheduleManager::_rescheduleNoLock(ScheduledTask& refTask, std::chrono::steady_clock::time_point finishTime)
+{
+    const auto interval = refTask.m_interval;
+    if (refTask.m_options.m_mode == schedule::TaskMode::TaskModeFixedDelay)
+    {
+		// one interval after the callback returned
+        _addTimerNoLock(refTask, finishTime + interval);
+        return;
+    }
+
+	// fixed rate : one interval after the due time, the period does not drift by the callback duration
+    auto nextExecutionTime = refTask.m_nextExecutionTime + interval;
+    if (nextExecutionTime <= finishTime)
+    {
+		// the callback overran one or more periods
+        const auto missedPeriods = (finishTime - nextExecutionTime) / interval + 1;
+        switch (refTask.m_options.m_catchUp)
+        {
+        case schedule::CatchUpPolicy::CatchUpBurst:
+			// run the missed periods back to back, but never more than SCHEDULE_MAX_CATCH_UP_RUNS
+            if (missedPeriods > SCHEDULE_MAX_CATCH_UP_RUNS)
+            {
+                nextExecutionTime += (missedPeriods - SCHEDULE_MAX_CATCH_UP_RUNS) * interval;
+                refTask.m_skippedPeriods += missedPeriods - SCHEDULE_MAX_CATCH_UP_RUNS;
+                m_skippedPeriods.add(missedPeriods - SCHEDULE_MAX_CATCH_UP_RUNS);
+            }
+            break;
+        case schedule::CatchUpPolicy::CatchUpRestart:
+            nextExecutionTime = finishTime + interval;
+            refTask.m_skippedPeriods += missedPeriods;
+            m_skippedPeriods.add(missedPeriods);
+            break;
+        case schedule::CatchUpPolicy::CatchUpSkip:
+        default:
+			// the first period on the original grid after the callback returned
+            nextExecutionTime += missedPeriods * interval;
+            refTask.m_skippedPeriods += missedPeriods;
+            m_skippedPeriods.add(missedPeriods);
+            break;
+        }
+    }
+    _addTimerNoLock(refTask, nextExecutionTime);
+}
+
+bool ScheduledTaskHandle::isActive() const
+{
+    return (m_taskId != 0) && ScheduleManager::instance().isTaskActive(m_taskId);
+}
+
+bool ScheduledTaskHandle::cancel() const
+{
+    return (m_taskId != 0) && ScheduleManager::instance().cancelTask(m_taskId);
+}
+
+bool ScheduledTaskHandle::reschedule(std::chrono::steady_clock::duration interval) const
+{
+    return (m_taskId != 0) && ScheduleManager::instance().rescheduleTask(m_taskId, interval);
+}
@@ -3,24 +3,86 @@
 #define SCHEDULE_MANAGER_H
 
 #include <vector>
+#include <queue>
+#include <set>
+#include <unordered_map>
 #include <functional>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <iostream>
+#include <string>
+#include "../../include/globalDefine.h"
+#include "../../utils/histogram.h"
+#include "../../utils/counter.h"
+#include "../../utils/profiledMutex.h"
+
+// options of a scheduled task
+struct ScheduleOptions
+{
+	std::string m_name = "";                                                    // shown by the "sched" command ("task<id>" if empty)
+	bool m_isRepeating = true;                                                  // is the task repeating
+	schedule::TaskPriority m_priority = schedule::TaskPriority::TaskPriorityNormal; // order among the ready tasks
+	bool m_isLongRunning = false;                                               // runs on the long-running workers, never delays the short tasks
+	schedule::TaskMode m_mode = schedule::TaskMode::TaskModeFixedRate;          // how the next execution time is computed
+	schedule::CatchUpPolicy m_catchUp = schedule::CatchUpPolicy::CatchUpSkip;   // fixed-rate only, what to do after an overrun
+};
 
 struct ScheduledTask
 {
+	uint64_t m_taskId = 0;                  // key of the task, also held by its handle
 	std::function<void()> m_funcCallback;   // callback function to be executed
-	std::chrono::seconds m_interval;        // interval (seconds), use std::chrono::seconds for better readability
-	std::chrono::steady_clock::time_point m_lastExecutionTime;  // last execution time
-	bool m_isRepeating;                     // is the task repeating
+	std::chrono::steady_clock::duration m_interval{};                   // execution interval
+	std::chrono::steady_clock::time_point m_nextExecutionTime{};        // next execution time
+	ScheduleOptions m_options{};
+	bool m_isRunning = false;               // the callback is running on a worker (not in the timer set)
 
-    ScheduledTask(std::function<void()> cb, std::chrono::seconds iv, bool repeat = true)
-        : m_funcCallback(std::move(cb)), m_interval(iv), m_lastExecutionTime(std::chrono::steady_clock::now()), m_isRepeating(repeat)
-    {
-    }
+	// statistics, updated under the schedule lock
+	uint64_t m_runs = 0;                    // callbacks finished
+	uint64_t m_overruns = 0;                // callbacks that ran longer than the interval
+	uint64_t m_skippedPeriods = 0;          // fixed-rate periods dropped by the catch-up policy
+	LatencyHistogram m_runTimeHistogram;    // callback duration (us)
+	LatencyHistogram m_latenessHistogram;   // callback start minus due time (us), waiting for a free worker included
+};
+
+// statistics of one task, copied out by ScheduleManager::getTaskStats
+struct ScheduledTaskStats
+{
+    uint64_t m_taskId = 0;
+    std::string m_name = "";
+    std::chrono::steady_clock::duration m_interval{};
+    bool m_isLongRunning = false;
+    bool m_isRunning = false;
+    uint64_t m_runs = 0;
+    uint64_t m_overruns = 0;
+    uint64_t m_skippedPeriods = 0;
+    uint64_t m_runTimeP50Us = 0;
+    uint64_t m_runTimeP99Us = 0;
+    uint64_t m_runTimeMaxUs = 0;
+    uint64_t m_latenessMeanUs = 0;
+    uint64_t m_latenessP99Us = 0;
+    uint64_t m_latenessMaxUs = 0;
+};
+
+// handle of a registered task, copyable, stays valid after the task is gone (operations then return false)
+class ScheduledTaskHandle
+{
+public:
+    ScheduledTaskHandle() = default;
+    explicit ScheduledTaskHandle(uint64_t taskId) : m_taskId(taskId) {}
+
+    uint64_t getTaskId() const { return m_taskId; }
+	// the task is registered and not cancelled (a one-time task is gone after it ran)
+    bool isActive() const;
+	// remove the task, a running callback finishes but the task is not run again
+    bool cancel() const;
+	// change the interval, the next execution is one new interval from now
+    bool reschedule(std::chrono::steady_clock::duration interval) const;
+
+private:
+    uint64_t m_taskId = 0;
 };
 
 class ScheduleManager
@@ -36,11 +98,38 @@ public:
 
     void release();
 
+    // register a new task
+	// funcCallback: function to be called when the task is executed
+	// interval: execution interval, the first execution is one interval from now
+	// options: repeating, priority, long-running, fixed-rate/fixed-delay and catch-up policy
+	// a repeating task is scheduled again only after its callback returns, so it never runs concurrently with itself
+    ScheduledTaskHandle registerTask(std::function<void()> funcCallback, std::chrono::steady_clock::duration interval, const ScheduleOptions& options = ScheduleOptions());
+
     // register a new task
 	// funcCallback: function to be called when the task is executed
 	// intervalSeconds: execution interval in seconds
 	// isRepeating: whether the task is repeating (default is true)
-    void registerTask(std::function<void()> funcCallback, int intervalSeconds, bool m_isRepeating = true);
+	// priority: order among the tasks waiting for a worker
+	// isLongRunning: run on the long-running workers (database flush, snapshot, ...)
+    ScheduledTaskHandle registerTask(std::function<void()> funcCallback, int intervalSeconds, bool m_isRepeating = true,
+        schedule::TaskPriority priority = schedule::TaskPriority::TaskPriorityNormal, bool isLongRunning = false);
+
+	// O(log n) operations of ScheduledTaskHandle
+    bool isTaskActive(uint64_t taskId);
+    bool cancelTask(uint64_t taskId);
+    bool rescheduleTask(uint64_t taskId, std::chrono::steady_clock::duration interval);
+
+	// statistics of all registered tasks, ordered by task id
+    void getTaskStats(std::vector<ScheduledTaskStats>& refVecStats);
+
+	// totals over all tasks, read without the schedule lock (metrics)
+    uint64_t getTaskRuns() const { return m_taskRuns.get(); }
+    uint64_t getTaskOverruns() const { return m_taskOverruns.get(); }
+    uint64_t getSkippedPeriods() const { return m_skippedPeriods.get(); }
+	// due tasks waiting for a worker
+    int64_t getReadyTaskCounts() const { return m_readyTaskCounts.load(std::memory_order_relaxed); }
+    const LatencyHistogram& getRunTimeHistogram() const { return m_runTimeHistogram; }
+    const LatencyHistogram& getLatenessHistogram() const { return m_latenessHistogram; }
 
 private:
     ScheduleManager();
@@ -51,13 +140,61 @@ private:
     ScheduleManager(ScheduleManager&&) = delete;
     ScheduleManager& operator=(ScheduleManager&&) = delete;
 
-    std::vector<ScheduledTask> m_vecTasks{};
-	std::mutex m_mutex;             // lock for thread safety
+	// a due task waiting for a worker
+    struct ReadyTask
+    {
+        schedule::TaskPriority m_priority = schedule::TaskPriority::TaskPriorityNormal;
+        std::chrono::steady_clock::time_point m_dueTime{};
+        uint64_t m_taskId = 0;
+    };
+	// order of the ready queues, the highest priority on top, then the earliest due time
+    struct ReadyTaskLowerPriority
+    {
+        bool operator()(const ReadyTask& lhs, const ReadyTask& rhs) const
+        {
+            if (lhs.m_priority != rhs.m_priority)
+            {
+                return lhs.m_priority < rhs.m_priority;
+            }
+            return lhs.m_dueTime > rhs.m_dueTime;
+        }
+    };
+    using ReadyTaskQueue = std::priority_queue<ReadyTask, std::vector<ReadyTask>, ReadyTaskLowerPriority>;
+    using TimerKey = std::pair<std::chrono::steady_clock::time_point, uint64_t/* task id */>;
+
+    std::unordered_map<uint64_t/* task id */, ScheduledTask> m_mapTasks{};  // all registered tasks
+    std::set<TimerKey> m_setTimers{};           // waiting tasks ordered by next execution time, the earliest first
+    ReadyTaskQueue m_queReadyTasks{};           // due tasks waiting for an executor worker
+    ReadyTaskQueue m_queLongRunningTasks{};     // due tasks waiting for a long-running worker
+	uint64_t m_nextTaskId = 1;
+	ProfiledMutex m_mutex{ "ScheduleManager::m_mutex" };    // lock for m_mapTasks, m_setTimers, the ready queues, m_running
+	std::condition_variable m_cvTasks;          // wake up the timer for a new task or release
+	std::condition_variable m_cvLongRunning;    // wake up the long-running workers
+	std::condition_variable m_cvIdle;           // release waits for the short tasks running on the executor
+	uint32_t m_runningShortTasks = 0;           // short tasks running on the executor
+
+	std::thread m_workerThread;                 // timer thread, moves due tasks to the ready queues
+	std::vector<std::thread> m_vecWorkerThreads{};  // long-running workers, short tasks run on ExecutorManager
+	std::atomic<bool> m_running;                // thread control flag
 
-	std::thread m_workerThread;     // thread for task scheduling
-	std::atomic<bool> m_running;    // thread control flag
+	// totals over all tasks (metrics)
+	ShardedCounter m_taskRuns;
+	ShardedCounter m_taskOverruns;
+	ShardedCounter m_skippedPeriods;
+	std::atomic<int64_t> m_readyTaskCounts = 0; // entries of both ready queues
+	LatencyHistogram m_runTimeHistogram;        // callback duration of all tasks (us)
+	LatencyHistogram m_latenessHistogram;       // callback start minus due time of all tasks (us)
 
     void workerLoop();
+    void longRunningWorkerLoop();
+	// executor job, runs the short ready task with the highest priority
+    void runShortTask();
+	// pop and run the top task of refQueue, the lock is released during the callback
+    void _runReadyTask(std::unique_lock<ProfiledMutex>& refLock, ReadyTaskQueue& refQueue);
+	// put a task on the timer set, wake up the timer if it is the earliest
+    void _addTimerNoLock(ScheduledTask& refTask, std::chrono::steady_clock::time_point nextExecutionTime);
+	// put a repeating task back on the timer set after it has run
+    void _rescheduleNoLock(ScheduledTask& refTask, std::chrono::steady_clock::time_point finishTime);
 };
 
-#endif // SCHEDULE_MANAGER_H
\ No newline at end of file
+#endif // SCHEDULE_MANAGER_H
@@ -0,0 +1,337 @@
+// @file  : snapshotManager.cpp
+// @brief : binary snapshot of all player records for fast warm restarts
+// @author: August
+// @date  : 2025-06-02
+#include "snapshotManager.h"
+#include "playerManager.h"
+#include "../../utils/utils.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const uint32_t SNAPSHOT_MAGIC = 0x53534D47;     // "GMSS"
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint64_t SNAPSHOT_MIN_RECORDS_PER_PARTITION = 250000;  // min records for each thread when constructing players
+
+static_assert(sizeof(PlayerRecord) == 24, "PlayerRecord layout is part of the snapshot file format");
+static_assert(std::is_trivially_copyable<PlayerRecord>::value, "PlayerRecord must be trivially copyable");
+static_assert(sizeof(SnapshotHeader) == 40, "SnapshotHeader layout is part of the snapshot file format");
+
+// word-wise FNV-1a, data size is always a multiple of 8 (record size is 24 bytes)
+static uint64_t calcChecksum(const uint8_t* pData, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const size_t words = size / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, pData + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// read-only memory mapped file
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path)
+    {
+#ifdef _WIN32
+        m_hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_hFile == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_hMapping)
+        {
+            close();
+            return false;
+        }
+        m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_pData)
+        {
+            close();
+            return false;
+        }
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0)
+        {
+            return false;
+        }
+        struct stat fileStat {};
+        if (fstat(m_fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close();
+            return false;
+        }
+        void* pMapped = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (pMapped == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        m_pData = static_cast<const uint8_t*>(pMapped);
+        m_size = static_cast<size_t>(fileStat.st_size);
+        madvise(pMapped, m_size, MADV_SEQUENTIAL);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (m_pData) UnmapViewOfFile(m_pData);
+        if (m_hMapping) CloseHandle(m_hMapping);
+        if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+        m_hMapping = nullptr;
+        m_hFile = INVALID_HANDLE_VALUE;
+#else
+        if (m_pData) munmap(const_cast<uint8_t*>(m_pData), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_pData = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t* data() const { return m_pData; }
+    size_t size() const { return m_size; }
+
+private:
+    const uint8_t* m_pData = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_hFile = INVALID_HANDLE_VALUE;
+    HANDLE m_hMapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+SnapshotManager& SnapshotManager::instance()
+{
+    static SnapshotManager instance;
+    return instance;
+}
+
+SnapshotManager::SnapshotManager()
+    : m_fileName("gameMatch.snapshot")
+{
+}
+
+SnapshotManager::~SnapshotManager()
+{
+}
+
+bool SnapshotManager::initialize()
+{
+    m_isDataLoaded = false;
+    std::cout << "[SnapshotManager] : initialized!" << std::endl;
+    return true;
+}
+
+void SnapshotManager::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_isDataLoaded = false;
+    std::cout << "[SnapshotManager] : released!" << std::endl;
+}
+
+bool SnapshotManager::writeSnapshot()
+{
+    if (!m_isDataLoaded)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto beginTime = std::chrono::steady_clock::now();
+
+	// take the time before copying, rows updated in db after this time will be replayed at startup
+    SnapshotHeader header;
+    header.m_magic = SNAPSHOT_MAGIC;
+    header.m_version = SNAPSHOT_VERSION;
+    header.m_snapshotTime = time_utils::getTimestampMS();
+
+    std::vector<PlayerRecord> vecRecords;
+    PlayerManager::instance().getPlayerRecords(vecRecords);
+
+    header.m_recordCounts = vecRecords.size();
+    for (const auto& record : vecRecords)
+    {
+        header.m_maxPlayerId = std::max(header.m_maxPlayerId, record.m_id);
+    }
+    const size_t recordBytes = vecRecords.size() * sizeof(PlayerRecord);
+    header.m_checksum = calcChecksum(reinterpret_cast<const uint8_t*>(vecRecords.data()), recordBytes);
+
+    const std::string tmpFileName = m_fileName + ".tmp";
+    FILE* pFile = file_utils::openFile(tmpFileName, "wb");
+    if (!pFile)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to open file : " << tmpFileName
+            << std::endl;
+        return false;
+    }
+    bool isOk = (std::fwrite(&header, sizeof(header), 1, pFile) == 1);
+    if (isOk && recordBytes > 0)
+    {
+        isOk = (std::fwrite(vecRecords.data(), recordBytes, 1, pFile) == 1);
+    }
+    isOk = isOk && file_utils::syncFile(pFile);
+    std::fclose(pFile);
+
+    if (!isOk || !file_utils::replaceFile(tmpFileName, m_fileName))
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to write snapshot file : " << m_fileName
+            << std::endl;
+        std::remove(tmpFileName.c_str());
+        return false;
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    std::cout << "[SnapshotManager] : wrote " << header.m_recordCounts << " player records in " << elapsedMs << " ms." << std::endl;
+    return true;
+}
+
+// *** called by dbManager while loading table data, players are constructed without PlayerManager lock ***
+bool SnapshotManager::loadSnapshot(uint64_t& refSnapshotTime, uint64_t& refMaxPlayerId)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto beginTime = std::chrono::steady_clock::now();
+
+    MappedFile mappedFile;
+    if (!mappedFile.open(m_fileName))
+    {
+        std::cout << "[SnapshotManager] : no snapshot file found." << std::endl;
+        return false;
+    }
+    if (mappedFile.size() < sizeof(SnapshotHeader))
+    {
+        std::cerr << "[WARNING] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Snapshot file is truncated."
+            << std::endl;
+        return false;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, mappedFile.data(), sizeof(header));
+    if (header.m_magic != SNAPSHOT_MAGIC || header.m_version != SNAPSHOT_VERSION)
+    {
+        std::cerr << "[WARNING] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Snapshot file version mismatch, version : " << header.m_version
+            << std::endl;
+        return false;
+    }
+    const size_t recordBytes = static_cast<size_t>(header.m_recordCounts) * sizeof(PlayerRecord);
+    if (mappedFile.size() != sizeof(SnapshotHeader) + recordBytes)
+    {
+        std::cerr << "[WARNING] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Snapshot file size mismatch."
+            << std::endl;
+        return false;
+    }
+    const uint8_t* pRecordData = mappedFile.data() + sizeof(SnapshotHeader);
+    if (calcChecksum(pRecordData, recordBytes) != header.m_checksum)
+    {
+        std::cerr << "[WARNING] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Snapshot file checksum mismatch."
+            << std::endl;
+        return false;
+    }
+
+	// construct players in parallel partitions, then merge them into PlayerManager
+    const uint64_t recordCounts = header.m_recordCounts;
+    uint64_t partitionCounts = std::max<uint64_t>(1, std::thread::hardware_concurrency());
+    partitionCounts = std::min<uint64_t>(partitionCounts, std::max<uint64_t>(1, recordCounts / SNAPSHOT_MIN_RECORDS_PER_PARTITION));
+    const uint64_t recordStep = (recordCounts + partitionCounts - 1) / partitionCounts;
+
+    std::vector<std::vector<std::unique_ptr<Player>>> vecPartitions(partitionCounts);
+    std::vector<std::thread> vecWorkers;
+    vecWorkers.reserve(partitionCounts);
+    for (uint64_t i = 0; i < partitionCounts; i++)
+    {
+        const uint64_t beginIndex = std::min(recordCounts, i * recordStep);
+        const uint64_t endIndex = std::min(recordCounts, beginIndex + recordStep);
+        vecWorkers.emplace_back([pRecordData, beginIndex, endIndex, &vecPartitions, i]()
+            {
+                std::vector<std::unique_ptr<Player>>& vecPartition = vecPartitions[i];
+                vecPartition.reserve(endIndex - beginIndex);
+                PlayerRecord record;
+                for (uint64_t index = beginIndex; index < endIndex; index++)
+                {
+                    std::memcpy(&record, pRecordData + index * sizeof(PlayerRecord), sizeof(PlayerRecord));
+                    if (record.m_id == 0)
+                    {
+                        continue;
+                    }
+                    vecPartition.emplace_back(std::make_unique<Player>(record.m_id, record.m_score, record.m_wins, record.m_updatedTime));
+                }
+            });
+    }
+    for (auto& worker : vecWorkers)
+    {
+        worker.join();
+    }
+
+    PlayerManager::instance().reservePlayersNoLock(recordCounts);
+    for (auto& vecPartition : vecPartitions)
+    {
+        PlayerManager::instance().mergePlayersFromDbNoLock(vecPartition);
+    }
+
+    refSnapshotTime = header.m_snapshotTime;
+    refMaxPlayerId = header.m_maxPlayerId;
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - beginTime).count();
+    std::cout << "[SnapshotManager] : loaded " << recordCounts << " player records (snapshot time "
+        << time_utils::formatTimestampMs(header.m_snapshotTime) << ") in " << elapsedMs << " ms." << std::endl;
+    return true;
+}
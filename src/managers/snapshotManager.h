@@ -0,0 +1,54 @@
+// snapshotManager.h
+#ifndef SNAPSHOT_MANAGER_H
+#define SNAPSHOT_MANAGER_H
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// snapshot file layout :
+// [SnapshotHeader][PlayerRecord * m_recordCounts]
+struct SnapshotHeader
+{
+	uint32_t m_magic = 0;           // SNAPSHOT_MAGIC
+	uint32_t m_version = 0;         // SNAPSHOT_VERSION
+	uint64_t m_snapshotTime = 0;    // timestamp(ms) when the records were copied
+	uint64_t m_recordCounts = 0;    // number of records
+	uint64_t m_maxPlayerId = 0;     // max player id in records, used to detect a stale snapshot
+	uint64_t m_checksum = 0;        // checksum of all records
+};
+
+class SnapshotManager
+{
+public:
+    static SnapshotManager& instance();
+
+    bool initialize();
+    void release();
+
+	// write all player records into the snapshot file (write tmp file then replace)
+    bool writeSnapshot();
+	// map the snapshot file and bulk-construct players into PlayerManager
+	// refSnapshotTime : the time the snapshot was taken, rows updated after it should be replayed from db
+	// refMaxPlayerId : max player id in the snapshot
+    bool loadSnapshot(uint64_t& refSnapshotTime, uint64_t& refMaxPlayerId);
+
+	// allow periodic writing after the player data is fully loaded
+    void markDataLoaded() { m_isDataLoaded = true; }
+
+private:
+    SnapshotManager();
+    ~SnapshotManager();
+
+    SnapshotManager(const SnapshotManager&) = delete;
+    SnapshotManager& operator=(const SnapshotManager&) = delete;
+    SnapshotManager(SnapshotManager&&) = delete;
+    SnapshotManager& operator=(SnapshotManager&&) = delete;
+
+    std::string m_fileName = "";
+	std::atomic<bool> m_isDataLoaded = false;   // never write a snapshot of partially loaded data
+	std::mutex m_mutex;                         // lock for writing snapshot file
+};
+
+#endif // SNAPSHOT_MANAGER_H
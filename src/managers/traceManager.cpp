@@ -0,0 +1,226 @@
+// @file  : traceManager.cpp
+// @brief : scoped spans in per-thread buffers, written as Chrome trace-event JSON
+// @author: August
+// @date  : 2025-06-18
+#include "traceManager.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+std::atomic<bool> TraceManager::m_isEnabled = false;
+
+// name given by setThreadName, copied to the buffer when the thread records its first span
+static thread_local const char* t_threadName = nullptr;
+
+// buffer of the calling thread, closed when the thread exits
+struct TraceThreadBuffer
+{
+    std::shared_ptr<TraceManager::TraceBuffer> m_pBuffer;
+
+    ~TraceThreadBuffer()
+    {
+        if (m_pBuffer)
+        {
+            m_pBuffer->m_isClosed.store(true, std::memory_order_release);
+        }
+    }
+};
+static thread_local TraceThreadBuffer t_threadBuffer;
+
+// escape the characters JSON does not allow in a string
+static void writeJsonString(std::ofstream& refFile, const char* text)
+{
+    refFile << '"';
+    for (const char* p = text; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            refFile << '\\' << *p;
+        }
+        else if (static_cast<unsigned char>(*p) >= 0x20)
+        {
+            refFile << *p;
+        }
+    }
+    refFile << '"';
+}
+
+TraceManager& TraceManager::instance()
+{
+    static TraceManager instance;
+    return instance;
+}
+
+TraceManager::TraceManager()
+{
+}
+
+TraceManager::~TraceManager()
+{
+}
+
+uint64_t TraceManager::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TraceManager::setThreadName(const char* name)
+{
+    t_threadName = name;
+    if (t_threadBuffer.m_pBuffer)
+    {
+        std::lock_guard<std::mutex> lock(t_threadBuffer.m_pBuffer->m_mutex);
+        t_threadBuffer.m_pBuffer->m_threadName = name;
+    }
+}
+
+bool TraceManager::start(const std::string& fileName)
+{
+    std::lock_guard<std::mutex> controlLock(m_controlMutex);
+    if (m_isEnabled.load())
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        for (auto it = m_vecBuffers.begin(); it != m_vecBuffers.end();)
+        {
+            if ((*it)->m_isClosed.load(std::memory_order_acquire))
+            {
+				// the thread is gone, its spans belong to the last trace
+                it = m_vecBuffers.erase(it);
+                continue;
+            }
+            std::lock_guard<std::mutex> bufferLock((*it)->m_mutex);
+            (*it)->m_vecEvents.clear();
+            ++it;
+        }
+    }
+    m_fileName = fileName;
+    m_beginUs = nowUs();
+    m_droppedEvents = 0;
+    m_isEnabled.store(true);
+    std::cout << "[TraceManager] : recording to " << m_fileName << std::endl;
+    return true;
+}
+
+bool TraceManager::stop()
+{
+    std::lock_guard<std::mutex> controlLock(m_controlMutex);
+    if (!m_isEnabled.load())
+    {
+        return false;
+    }
+	// spans already started still finish into the buffers, the ones ending after the write are cleared by the next start
+    m_isEnabled.store(false);
+    return _writeTrace(m_fileName, m_beginUs);
+}
+
+void TraceManager::release()
+{
+    if (m_isEnabled.load())
+    {
+        stop();
+    }
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    m_vecBuffers.clear();
+}
+
+void TraceManager::record(const char* name, uint64_t beginUs, uint64_t endUs)
+{
+    if (!t_threadBuffer.m_pBuffer)
+    {
+        t_threadBuffer.m_pBuffer = _registerBuffer();
+    }
+    TraceBuffer& refBuffer = *t_threadBuffer.m_pBuffer;
+    std::lock_guard<std::mutex> lock(refBuffer.m_mutex);
+    if (refBuffer.m_vecEvents.size() >= MAX_THREAD_EVENTS)
+    {
+        m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    refBuffer.m_vecEvents.push_back({ name, beginUs, endUs - beginUs });
+}
+
+std::shared_ptr<TraceManager::TraceBuffer> TraceManager::_registerBuffer()
+{
+    auto pBuffer = std::make_shared<TraceBuffer>();
+    pBuffer->m_threadName = t_threadName;
+    std::lock_guard<std::mutex> lock(m_buffersMutex);
+    pBuffer->m_threadId = m_nextThreadId++;
+    m_vecBuffers.emplace_back(pBuffer);
+    return pBuffer;
+}
+
+bool TraceManager::_writeTrace(const std::string& fileName, uint64_t beginUs)
+{
+    std::ofstream file(fileName, std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to open trace file : " << fileName
+            << std::endl;
+        return false;
+    }
+
+    uint64_t eventCounts = 0;
+    bool isFirst = true;
+    file << "{\"traceEvents\":[\n";
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        for (auto& pBuffer : m_vecBuffers)
+        {
+			// move the spans out, the thread keeps recording into an empty buffer
+            std::vector<TraceEvent> vecEvents;
+            const char* threadName = nullptr;
+            {
+                std::lock_guard<std::mutex> bufferLock(pBuffer->m_mutex);
+                vecEvents.swap(pBuffer->m_vecEvents);
+                threadName = pBuffer->m_threadName;
+            }
+            if (vecEvents.empty())
+            {
+                continue;
+            }
+
+            if (threadName)
+            {
+                file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pBuffer->m_threadId << ",\"args\":{\"name\":";
+                writeJsonString(file, threadName);
+                file << "}}";
+                isFirst = false;
+            }
+            for (const auto& event : vecEvents)
+            {
+                if (event.m_beginUs < beginUs)
+                {
+					// started before the trace
+                    continue;
+                }
+                file << (isFirst ? "" : ",\n") << "{\"name\":";
+                writeJsonString(file, event.m_name);
+                file << ",\"cat\":\"gamematch\",\"ph\":\"X\",\"ts\":" << (event.m_beginUs - beginUs)
+                    << ",\"dur\":" << event.m_durationUs << ",\"pid\":1,\"tid\":" << pBuffer->m_threadId << "}";
+                isFirst = false;
+                eventCounts++;
+            }
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    file.close();
+    if (!file)
+    {
+        std::cerr << "[ERROR] "
+            << "[" << __FILE__ << ":" << __LINE__ << "] "
+            << "[" << __func__ << "] "
+            << "Failed to write trace file : " << fileName
+            << std::endl;
+        return false;
+    }
+    m_eventCounts = eventCounts;
+    std::cout << "[TraceManager] : wrote " << eventCounts << " spans to " << fileName
+        << " (" << m_droppedEvents.load() << " dropped)" << std::endl;
+    return true;
+}
@@ -0,0 +1,125 @@
+// traceManager.h
+#ifndef TRACE_MANAGER_H
+#define TRACE_MANAGER_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+// one finished span, the name is a string literal
+struct TraceEvent
+{
+	const char* m_name = nullptr;
+	uint64_t m_beginUs = 0;             // steady clock, converted to the trace start when written
+	uint64_t m_durationUs = 0;
+};
+
+// recorder of scoped spans on the hot paths, written as a Chrome trace-event JSON file (chrome://tracing, ui.perfetto.dev)
+// every thread records into its own buffer, the buffer lock is only contended while a trace is written
+// spans measure the real steady clock, also under the virtual clock
+// *** span and thread names are read when the trace is written, only pass literals or static strings ***
+class TraceManager
+{
+public:
+    static const size_t MAX_THREAD_EVENTS = 1 << 20;    // per thread and trace, later spans are dropped
+
+    static TraceManager& instance();
+
+	// clear the buffers and start recording, the trace is written to fileName by stop(), false if already recording
+    bool start(const std::string& fileName);
+	// stop recording and write the trace, false if not recording or the file can not be written
+    bool stop();
+	// stop and write a trace still recording at shutdown
+    void release();
+
+	// the only check of a disabled span
+    static bool isEnabled() { return m_isEnabled.load(std::memory_order_relaxed); }
+    static uint64_t nowUs();
+	// name of the calling thread in the trace, call before its first span
+    static void setThreadName(const char* name);
+
+    void record(const char* name, uint64_t beginUs, uint64_t endUs);
+
+    const std::string& getFileName() const { return m_fileName; }
+	// spans in the last trace written
+    uint64_t getEventCounts() const { return m_eventCounts; }
+    uint64_t getDroppedEvents() const { return m_droppedEvents.load(std::memory_order_relaxed); }
+
+    struct TraceBuffer
+    {
+		std::mutex m_mutex;                 // lock for m_vecEvents
+        std::vector<TraceEvent> m_vecEvents{};
+		uint32_t m_threadId = 0;            // "tid" of the trace, in registration order
+		const char* m_threadName = nullptr;
+		std::atomic<bool> m_isClosed{ false };  // the owner thread exited, removed once written
+    };
+
+private:
+    TraceManager();
+    ~TraceManager();
+
+    TraceManager(const TraceManager&) = delete;
+    TraceManager& operator=(const TraceManager&) = delete;
+    TraceManager(TraceManager&&) = delete;
+    TraceManager& operator=(TraceManager&&) = delete;
+
+	// create the buffer of the calling thread
+    std::shared_ptr<TraceBuffer> _registerBuffer();
+	// "traceEvents" JSON of all buffers, false if the file can not be written
+    bool _writeTrace(const std::string& fileName, uint64_t beginUs);
+
+    static std::atomic<bool> m_isEnabled;
+
+    std::vector<std::shared_ptr<TraceBuffer>> m_vecBuffers{};
+	std::mutex m_buffersMutex;              // lock for m_vecBuffers, only taken once per thread and by start/stop
+	std::mutex m_controlMutex;              // serializes start and stop
+	std::string m_fileName = "";
+	uint64_t m_beginUs = 0;                 // spans started before are left out
+	uint32_t m_nextThreadId = 1;
+	uint64_t m_eventCounts = 0;
+	std::atomic<uint64_t> m_droppedEvents = 0;
+};
+
+// span from construction to the end of the scope
+// the flag is read once into m_name, so the constructor and destructor test the same value and fold into one branch when disabled
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name)
+        : m_name(TraceManager::isEnabled() ? name : nullptr)
+    {
+        if (m_name)
+        {
+            m_beginUs = TraceManager::nowUs();
+        }
+    }
+    ~TraceSpan()
+    {
+        end();
+    }
+	// end the span before the scope does
+    void end()
+    {
+        if (m_name)
+        {
+            TraceManager::instance().record(m_name, m_beginUs, TraceManager::nowUs());
+            m_name = nullptr;
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name = nullptr;
+    uint64_t m_beginUs = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif // TRACE_MANAGER_H
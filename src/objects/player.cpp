@@ -27,11 +27,17 @@ uint32_t Player::getTier() const
 
 void Player::addScore(uint32_t scoreDelta)
 {
+    if (scoreDelta == 0)
+    {
+        return;
+    }
     m_score += scoreDelta;
+    markDirty(common::PlayerDirtyField::DirtyScore);
 }
 
 void Player::subScore(uint32_t scoreDelta)
 {
+    const uint32_t orgScore = m_score;
     if (m_score >= scoreDelta)
     {
         m_score -= scoreDelta;
@@ -40,15 +46,74 @@ void Player::subScore(uint32_t scoreDelta)
     {
         m_score = 0;
 	}
+    if (m_score != orgScore)
+    {
+        markDirty(common::PlayerDirtyField::DirtyScore);
+    }
 }
 
 void Player::addWins()
 {
     m_wins++;
+    markDirty(common::PlayerDirtyField::DirtyWins);
+}
+
+void Player::applyBattleResult(uint32_t scoreDelta, bool isWin)
+{
+    uint8_t dirtyMask = common::PlayerDirtyField::DirtyNone;
+    if (isWin)
+    {
+        m_wins++;
+        dirtyMask |= common::PlayerDirtyField::DirtyWins;
+        if (scoreDelta > 0)
+        {
+            m_score += scoreDelta;
+            dirtyMask |= common::PlayerDirtyField::DirtyScore;
+        }
+    }
+    else if (m_score > 0 && scoreDelta > 0)
+    {
+        m_score = (m_score >= scoreDelta) ? (m_score - scoreDelta) : 0;
+        dirtyMask |= common::PlayerDirtyField::DirtyScore;
+    }
+    if (dirtyMask != common::PlayerDirtyField::DirtyNone)
+    {
+        markDirty(dirtyMask);
+    }
 }
 
 void Player::setStatus(common::PlayerStatus status)
 {
+    if (m_status == status)
+    {
+        return;
+    }
     m_status = status;
+    markDirty(common::PlayerDirtyField::DirtyStatus);
+}
+
+void Player::markDirty(uint8_t dirtyMask, uint64_t updatedTime)
+{
+    m_dirtyMask.fetch_or(dirtyMask);
+    if (dirtyMask & common::PlayerDirtyField::DirtyPersisted)
+    {
+        m_version.fetch_add(1);
+		// the wall clock like the db rows, see DbManager::updatePlayerBattles
+        m_updatedTime = (updatedTime > 0) ? updatedTime : time_utils::getTimestampMS();
+    }
+}
+
+uint8_t Player::takePersistedDirty()
+{
+	// status is never saved, drop it as well
+    const uint8_t dirtyMask = m_dirtyMask.exchange(common::PlayerDirtyField::DirtyNone);
+    return (dirtyMask & common::PlayerDirtyField::DirtyPersisted);
 }
 
+// overwrite battle data with newer data from storage
+void Player::syncBattleData(uint32_t score, uint32_t wins, uint64_t updatedTime)
+{
+    m_score = score;
+    m_wins = wins;
+    m_updatedTime = updatedTime;
+}
@@ -3,6 +3,24 @@
 #define PLAYER_H
 #include "../../include/globalDefine.h"
 #include <cstdint>
+#include <atomic>
+#include <chrono>
+
+// plain player battle data, used for bulk transfer between PlayerManager and storages
+struct PlayerRecord
+{
+	uint64_t m_id = 0;              // player ID
+	uint32_t m_score = 0;           // battle score
+	uint32_t m_wins = 0;            // battle wins
+	uint64_t m_updatedTime = 0;     // last updated time
+};
+
+// player data to be written, only the fields in m_dirtyMask are changed
+struct PlayerRecordUpdate
+{
+    PlayerRecord m_record;
+	uint8_t m_dirtyMask = common::PlayerDirtyField::DirtyNone; // common::PlayerDirtyField bits
+};
 
 class Player
 {
@@ -17,11 +35,32 @@ public:
     uint64_t getUpdatedTime() const { return m_updatedTime; };
     common::PlayerStatus getStatus() const { return m_status; }
     bool isInLobby() const { return (m_status == common::PlayerStatus::lobby); }
+    uint8_t getDirtyMask() const { return m_dirtyMask.load(); }
+    uint32_t getVersion() const { return m_version.load(); }
+    uint32_t getSavedVersion() const { return m_savedVersion; }
 
     void addScore(uint32_t scoreDelta);
     void subScore(uint32_t scoreDelta);
     void addWins();
+	// one battle result is one change of score and wins : one version, one updated time
+    void applyBattleResult(uint32_t scoreDelta, bool isWin);
     void setStatus(common::PlayerStatus status);
+    void syncBattleData(uint32_t score, uint32_t wins, uint64_t updatedTime);
+	// time the player joined the match queue (ClockManager::now), for the queue wait statistics
+    void setQueueEnterTime(std::chrono::steady_clock::time_point queueEnterTime) { m_queueEnterTime = queueEnterTime; }
+    std::chrono::steady_clock::time_point getQueueEnterTime() const { return m_queueEnterTime; }
+	// time the team of the player joined the battle queue
+    void setTeamEnterTime(std::chrono::steady_clock::time_point teamEnterTime) { m_teamEnterTime = teamEnterTime; }
+    std::chrono::steady_clock::time_point getTeamEnterTime() const { return m_teamEnterTime; }
+
+	// one logical change, a persisted field bumps the version once and sets the updated time (0 : now)
+    void markDirty(uint8_t dirtyMask, uint64_t updatedTime = 0);
+	// take the persisted dirty fields for saving, returns the taken fields (DirtyNone if nothing to save)
+    uint8_t takePersistedDirty();
+	// the taken fields are saved, version is the one when they were taken
+    void markSaved(uint32_t version) { m_savedVersion = version; }
+	// put back the taken fields after a failed save
+    void restoreDirty(uint8_t dirtyMask) { m_dirtyMask.fetch_or(dirtyMask); }
 
 private:
 	uint64_t m_id = 0;              // player ID
@@ -29,6 +68,12 @@ private:
 	uint32_t m_wins = 0;            // battle wins
 	uint64_t m_updatedTime = 0;     // last updated time
 	common::PlayerStatus m_status = common::PlayerStatus::offline;  // gaming status 
+	std::chrono::steady_clock::time_point m_queueEnterTime{};       // set by BattleManager::addPlayerToQueue
+	std::chrono::steady_clock::time_point m_teamEnterTime{};        // set when the team is formed
+
+	std::atomic<uint8_t> m_dirtyMask = common::PlayerDirtyField::DirtyNone;    // changed fields since last save
+	std::atomic<uint32_t> m_version = 0;    // increased once per change of persisted fields
+	uint32_t m_savedVersion = 0;            // version written by the last save
 };
 
 #endif // !PLAYER_H
\ No newline at end of file
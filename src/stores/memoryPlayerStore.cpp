@@ -0,0 +1,104 @@
+// @file  : memoryPlayerStore.cpp
+// @brief : player storage in memory
+// @author: August
+// @date  : 2025-06-06
+#include "memoryPlayerStore.h"
+#include "../managers/playerManager.h"
+#include <iostream>
+
+MemoryPlayerStore::MemoryPlayerStore()
+{
+}
+
+MemoryPlayerStore::~MemoryPlayerStore()
+{
+}
+
+bool MemoryPlayerStore::open()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mapRecords.clear();
+    m_nextId = 1;
+    std::cout << "[MemoryPlayerStore] : opened." << std::endl;
+    return true;
+}
+
+void MemoryPlayerStore::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mapRecords.clear();
+    std::cout << "[MemoryPlayerStore] : closed." << std::endl;
+}
+
+bool MemoryPlayerStore::loadAll()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::unique_ptr<Player>> vecPlayers;
+    vecPlayers.reserve(m_mapRecords.size());
+    for (const auto& itRecord : m_mapRecords)
+    {
+        const PlayerRecord& record = itRecord.second;
+        vecPlayers.emplace_back(std::make_unique<Player>(record.m_id, record.m_score, record.m_wins, record.m_updatedTime));
+    }
+    PlayerManager::instance().reservePlayersNoLock(vecPlayers.size());
+    PlayerManager::instance().mergePlayersFromDbNoLock(vecPlayers);
+    return true;
+}
+
+bool MemoryPlayerStore::loadOne(uint64_t id, PlayerRecord& refRecord)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_mapRecords.find(id);
+    if (it == m_mapRecords.end())
+    {
+        return false;
+    }
+    refRecord = it->second;
+    return true;
+}
+
+bool MemoryPlayerStore::loadMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (uint64_t id : refVecIds)
+    {
+        auto it = m_mapRecords.find(id);
+        if (it != m_mapRecords.end())
+        {
+            refVecRecords.emplace_back(it->second);
+        }
+    }
+    return true;
+}
+
+uint64_t MemoryPlayerStore::insert(PlayerRecord& refRecord)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    refRecord.m_id = m_nextId++;
+    m_mapRecords[refRecord.m_id] = refRecord;
+    return refRecord.m_id;
+}
+
+bool MemoryPlayerStore::batchUpdate(const std::vector<PlayerRecordUpdate>& refVecUpdates)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& update : refVecUpdates)
+    {
+        auto it = m_mapRecords.find(update.m_record.m_id);
+        if (it == m_mapRecords.end())
+        {
+            continue;
+        }
+        if (update.m_dirtyMask & common::PlayerDirtyField::DirtyScore)
+        {
+            it->second.m_score = update.m_record.m_score;
+        }
+        if (update.m_dirtyMask & common::PlayerDirtyField::DirtyWins)
+        {
+            it->second.m_wins = update.m_record.m_wins;
+        }
+        it->second.m_updatedTime = update.m_record.m_updatedTime;
+    }
+    return true;
+}
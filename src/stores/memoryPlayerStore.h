@@ -0,0 +1,35 @@
+// memoryPlayerStore.h
+#ifndef MEMORY_PLAYER_STORE_H
+#define MEMORY_PLAYER_STORE_H
+
+#include "playerStore.h"
+#include <unordered_map>
+#include <mutex>
+
+// player storage in memory, nothing survives a restart
+// used to measure matchmaking without disk I/O
+class MemoryPlayerStore : public PlayerStore
+{
+public:
+    MemoryPlayerStore();
+    ~MemoryPlayerStore() override;
+
+    const char* getName() const override { return "memory"; }
+    bool isPersistent() const override { return false; }
+
+    bool open() override;
+    void close() override;
+
+    bool loadAll() override;
+    bool loadOne(uint64_t id, PlayerRecord& refRecord) override;
+    bool loadMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords) override;
+    uint64_t insert(PlayerRecord& refRecord) override;
+    bool batchUpdate(const std::vector<PlayerRecordUpdate>& refVecUpdates) override;
+
+private:
+    std::unordered_map<uint64_t/* playerId */, PlayerRecord> m_mapRecords{};
+	uint64_t m_nextId = 1;  // auto increment player ID
+	std::mutex m_mutex;     // lock for m_mapRecords, m_nextId
+};
+
+#endif // MEMORY_PLAYER_STORE_H
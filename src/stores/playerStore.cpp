@@ -0,0 +1,20 @@
+// @file  : playerStore.cpp
+// @brief : factory of player storage backends
+// @author: August
+// @date  : 2025-06-06
+#include "playerStore.h"
+#include "sqlitePlayerStore.h"
+#include "memoryPlayerStore.h"
+
+std::unique_ptr<PlayerStore> createPlayerStore(const std::string& storeType, uint32_t dbShards)
+{
+    if (storeType == "sqlite")
+    {
+        return std::make_unique<SqlitePlayerStore>(dbShards);
+    }
+    if (storeType == "memory")
+    {
+        return std::make_unique<MemoryPlayerStore>();
+    }
+    return nullptr;
+}
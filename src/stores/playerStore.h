@@ -0,0 +1,40 @@
+// playerStore.h
+#ifndef PLAYER_STORE_H
+#define PLAYER_STORE_H
+
+#include "../objects/player.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// storage backend of player battle data, PlayerManager talks to storage only through this interface
+class PlayerStore
+{
+public:
+    virtual ~PlayerStore() {}
+
+    virtual const char* getName() const = 0;
+	// whether data survives a restart (snapshot and journal are only used for persistent stores)
+    virtual bool isPersistent() const = 0;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+
+	// load all players into PlayerManager
+    virtual bool loadAll() = 0;
+	// load one player record by id
+    virtual bool loadOne(uint64_t id, PlayerRecord& refRecord) = 0;
+	// load the found records of vecIds in one round trip, missing ids are skipped
+    virtual bool loadMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords) = 0;
+	// insert a new player, refRecord.m_id is set to the new id, returns the new id (0 if failed)
+    virtual uint64_t insert(PlayerRecord& refRecord) = 0;
+	// update the dirty fields of players
+    virtual bool batchUpdate(const std::vector<PlayerRecordUpdate>& refVecUpdates) = 0;
+};
+
+// create a store by type name : "sqlite" or "memory", returns nullptr for unknown type
+// dbShards : database files of the sqlite store (ignored by the memory store)
+std::unique_ptr<PlayerStore> createPlayerStore(const std::string& storeType, uint32_t dbShards = 1);
+
+#endif // PLAYER_STORE_H
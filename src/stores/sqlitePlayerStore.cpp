@@ -0,0 +1,71 @@
+// @file  : sqlitePlayerStore.cpp
+// @brief : player storage on sqlite
+// @author: August
+// @date  : 2025-06-06
+#include "sqlitePlayerStore.h"
+#include "../managers/dbManager.h"
+#include <iostream>
+
+SqlitePlayerStore::SqlitePlayerStore(uint32_t shardCounts)
+    : m_shardCounts(shardCounts)
+{
+}
+
+SqlitePlayerStore::~SqlitePlayerStore()
+{
+}
+
+bool SqlitePlayerStore::open()
+{
+    DbManager::instance().configure("gameMatch.db", m_shardCounts);
+    if (!DbManager::instance().initialize())
+    {
+        std::cerr << "Error: Failed to initialize DbManager!\n";
+        return false;
+    }
+	// connect to database
+    if (DbManager::instance().connect() == false)
+    {
+        std::cerr << "Error: Failed to connect to database!\n";
+        return false;
+    }
+	// make sure the database schema is correct
+    if (DbManager::instance().ensureTableSchema() == false)
+    {
+        std::cerr << "Error: Failed to ensure database schema!\n";
+        return false;
+    }
+    return true;
+}
+
+void SqlitePlayerStore::close()
+{
+    DbManager::instance().release();
+}
+
+bool SqlitePlayerStore::loadAll()
+{
+    return DbManager::instance().loadTableData();
+}
+
+bool SqlitePlayerStore::loadOne(uint64_t id, PlayerRecord& refRecord)
+{
+    refRecord.m_id = id;
+    return DbManager::instance().queryPlayerBattles(id, refRecord.m_score, refRecord.m_wins, refRecord.m_updatedTime);
+}
+
+bool SqlitePlayerStore::loadMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords)
+{
+    return DbManager::instance().queryPlayerBattlesMany(refVecIds, refVecRecords);
+}
+
+uint64_t SqlitePlayerStore::insert(PlayerRecord& refRecord)
+{
+    refRecord.m_id = DbManager::instance().insertPlayerBattles(refRecord.m_score, refRecord.m_wins, refRecord.m_updatedTime);
+    return refRecord.m_id;
+}
+
+bool SqlitePlayerStore::batchUpdate(const std::vector<PlayerRecordUpdate>& refVecUpdates)
+{
+    return DbManager::instance().updatePlayerBattlesBatch(refVecUpdates);
+}
@@ -0,0 +1,31 @@
+// sqlitePlayerStore.h
+#ifndef SQLITE_PLAYER_STORE_H
+#define SQLITE_PLAYER_STORE_H
+
+#include "playerStore.h"
+
+// player storage on sqlite, backed by DbManager
+class SqlitePlayerStore : public PlayerStore
+{
+public:
+	// player_battles is split over shardCounts database files
+    explicit SqlitePlayerStore(uint32_t shardCounts = 1);
+    ~SqlitePlayerStore() override;
+
+    const char* getName() const override { return "sqlite"; }
+    bool isPersistent() const override { return true; }
+
+    bool open() override;
+    void close() override;
+
+    bool loadAll() override;
+    bool loadOne(uint64_t id, PlayerRecord& refRecord) override;
+    bool loadMany(const std::vector<uint64_t>& refVecIds, std::vector<PlayerRecord>& refVecRecords) override;
+    uint64_t insert(PlayerRecord& refRecord) override;
+    bool batchUpdate(const std::vector<PlayerRecordUpdate>& refVecUpdates) override;
+
+private:
+    uint32_t m_shardCounts = 1;
+};
+
+#endif // SQLITE_PLAYER_STORE_H
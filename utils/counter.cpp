@@ -0,0 +1,36 @@
+// @file  : counter.cpp
+// @brief : per-thread counter aggregated on read
+// @author: August
+// @date  : 2025-06-17
+#include "counter.h"
+
+static std::atomic<size_t> s_nextSlotIndex = 0;
+
+ShardedCounter::ShardedCounter()
+{
+    reset();
+}
+
+uint64_t ShardedCounter::get() const
+{
+    uint64_t sum = 0;
+    for (const auto& slot : m_arrSlots)
+    {
+        sum += slot.m_value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void ShardedCounter::reset()
+{
+    for (auto& slot : m_arrSlots)
+    {
+        slot.m_value.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t ShardedCounter::_getSlotIndex()
+{
+    static thread_local size_t t_slotIndex = s_nextSlotIndex.fetch_add(1, std::memory_order_relaxed) % SLOT_COUNTS;
+    return t_slotIndex;
+}
@@ -0,0 +1,36 @@
+// counter.h
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// counter with one cache line per thread slot, add() does not contend with other threads (up to SLOT_COUNTS threads)
+// get() sums the slots on demand, for hot-path statistics read by the metrics endpoint without any lock
+class ShardedCounter
+{
+public:
+    static const size_t SLOT_COUNTS = 64;
+
+    ShardedCounter();
+
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void add(uint64_t value = 1) { m_arrSlots[_getSlotIndex()].m_value.fetch_add(value, std::memory_order_relaxed); }
+    uint64_t get() const;
+    void reset();
+
+private:
+	// slot of the calling thread, assigned round-robin on first use
+    static size_t _getSlotIndex();
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> m_value;
+    };
+    Slot m_arrSlots[SLOT_COUNTS];
+};
+
+#endif // COUNTER_H
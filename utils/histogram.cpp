@@ -0,0 +1,135 @@
+// @file  : histogram.cpp
+// @brief : lock-free duration histogram
+// @author: August
+// @date  : 2025-06-12
+#include "histogram.h"
+#include <limits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// index of the highest set bit, the value must not be 0
+static uint32_t getHighestBit(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#else
+	// binary search, 6 steps
+    uint32_t index = 0;
+    for (uint32_t shift = 32; shift > 0; shift >>= 1)
+    {
+        if (value >> shift)
+        {
+            value >>= shift;
+            index += shift;
+        }
+    }
+    return index;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t valueUs)
+{
+    m_arrBuckets[_getBucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(valueUs, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (valueUs > currentMax && !m_max.compare_exchange_weak(currentMax, valueUs, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : m_arrBuckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getMean() const
+{
+    const uint64_t count = getCount();
+    return (count > 0) ? (getSum() / count) : 0;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const
+{
+    const uint64_t count = getCount();
+    if (count == 0)
+    {
+        return 0;
+    }
+	// rank of the wanted value, 1-based
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+    rank = (rank < 1) ? 1 : ((rank > count) ? count : rank);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNTS; i++)
+    {
+        seen += m_arrBuckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            const uint64_t upperBound = getBucketUpperBound(i);
+            const uint64_t maxValue = getMax();
+            return (upperBound < maxValue) ? upperBound : maxValue;
+        }
+    }
+    return getMax();
+}
+
+uint64_t LatencyHistogram::getBucketCount(size_t bucketIndex) const
+{
+    return (bucketIndex < BUCKET_COUNTS) ? m_arrBuckets[bucketIndex].load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t bucketIndex)
+{
+    if (bucketIndex >= BUCKET_COUNTS - 1)
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    if (bucketIndex < 2 * SUB_BUCKET_COUNTS)
+    {
+        return bucketIndex;
+    }
+	// reverse of _getBucketIndex, the bucket is 2^shift wide
+    const uint32_t shift = static_cast<uint32_t>(bucketIndex / SUB_BUCKET_COUNTS) - 1;
+    const uint64_t lowerBound = static_cast<uint64_t>(SUB_BUCKET_COUNTS + bucketIndex % SUB_BUCKET_COUNTS) << shift;
+    return lowerBound + (1ULL << shift) - 1;
+}
+
+bool LatencyHistogram::isPowerOfTwoBound(size_t bucketIndex)
+{
+    const uint64_t upperBound = getBucketUpperBound(bucketIndex);
+    return (upperBound & (upperBound + 1)) == 0;
+}
+
+size_t LatencyHistogram::_getBucketIndex(uint64_t valueUs)
+{
+    if (valueUs < SUB_BUCKET_COUNTS)
+    {
+        return static_cast<size_t>(valueUs);
+    }
+    const uint32_t highestBit = getHighestBit(valueUs);
+    if (highestBit >= MAX_VALUE_BITS)
+    {
+        return BUCKET_COUNTS - 1;
+    }
+	// power of two group, then the SUB_BUCKET_BITS bits below the highest one pick the sub-bucket
+    const uint32_t shift = highestBit - SUB_BUCKET_BITS;
+    return static_cast<size_t>(highestBit - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNTS + static_cast<size_t>((valueUs >> shift) & (SUB_BUCKET_COUNTS - 1));
+}
@@ -0,0 +1,51 @@
+// histogram.h
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// histogram of durations in microseconds, every power of two split into linear sub-buckets (HDR histogram layout)
+// record() is lock-free and can be called from any thread, readers get an approximate but consistent-enough view
+// values below 2 * SUB_BUCKET_COUNTS have a bucket each, above a bucket is 1/SUB_BUCKET_COUNTS of its power of two wide,
+// so a bucket bound is at most 6.25% above the values in it, the last bucket holds everything from 2^MAX_VALUE_BITS
+class LatencyHistogram
+{
+public:
+    static const uint32_t SUB_BUCKET_BITS = 4;
+    static const size_t SUB_BUCKET_COUNTS = size_t(1) << SUB_BUCKET_BITS;
+    static const uint32_t MAX_VALUE_BITS = 40;
+    static const size_t BUCKET_COUNTS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNTS + 1;
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t valueUs);
+    void reset();
+
+    uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t getSum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t getMax() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t getMean() const;
+	// upper bound of the bucket holding the given percentile (0.0 ~ 100.0), never above the max
+    uint64_t getPercentile(double percentile) const;
+
+    uint64_t getBucketCount(size_t bucketIndex) const;
+	// largest value of a bucket
+    static uint64_t getBucketUpperBound(size_t bucketIndex);
+	// the bucket ends a power of two (its bound is 2^k - 1), for outputs that only want the coarse buckets
+    static bool isPowerOfTwoBound(size_t bucketIndex);
+
+private:
+    static size_t _getBucketIndex(uint64_t valueUs);
+
+    std::atomic<uint64_t> m_arrBuckets[BUCKET_COUNTS];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,111 @@
+// @file  : profiledMutex.cpp
+// @brief : mutex wrapper recording contention per named lock
+// @author: August
+// @date  : 2025-06-18
+#include "profiledMutex.h"
+
+LockProfiler& LockProfiler::instance()
+{
+    static LockProfiler instance;
+    return instance;
+}
+
+LockProfiler::LockProfiler()
+{
+}
+
+LockProfiler::~LockProfiler()
+{
+}
+
+bool LockProfiler::isCompiledIn()
+{
+#ifdef LOCK_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+LockStats* LockProfiler::getStats(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& uStats = m_mapStats[name];
+    if (!uStats)
+    {
+        uStats = std::make_unique<LockStats>();
+        uStats->m_name = name;
+    }
+    return uStats.get();
+}
+
+void LockProfiler::getAllStats(std::vector<const LockStats*>& refVecStats)
+{
+    refVecStats.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& statsPair : m_mapStats)
+    {
+        refVecStats.emplace_back(statsPair.second.get());
+    }
+}
+
+void LockProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& statsPair : m_mapStats)
+    {
+        LockStats& refStats = *statsPair.second;
+        refStats.m_acquisitions.store(0, std::memory_order_relaxed);
+        refStats.m_contendedAcquisitions.store(0, std::memory_order_relaxed);
+        refStats.m_waitHistogram.reset();
+        refStats.m_holdHistogram.reset();
+    }
+}
+
+#ifdef LOCK_PROFILING
+ProfiledMutex::ProfiledMutex(const char* name)
+    : m_pStats(LockProfiler::instance().getStats(name))
+{
+}
+
+void ProfiledMutex::lock()
+{
+	// the clock is only read when the lock has to be waited for
+    if (m_mutex.try_lock())
+    {
+        m_pStats->m_waitHistogram.record(0);
+    }
+    else
+    {
+        const auto beginTime = std::chrono::steady_clock::now();
+        m_mutex.lock();
+        m_pStats->m_waitHistogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - beginTime).count());
+        m_pStats->m_contendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_pStats->m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    _beginHold();
+}
+
+bool ProfiledMutex::try_lock()
+{
+    if (!m_mutex.try_lock())
+    {
+        return false;
+    }
+    m_pStats->m_waitHistogram.record(0);
+    m_pStats->m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    _beginHold();
+    return true;
+}
+
+void ProfiledMutex::unlock()
+{
+    _endHold();
+    m_mutex.unlock();
+}
+
+void ProfiledMutex::_endHold()
+{
+    m_pStats->m_holdHistogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_holdBeginTime).count());
+}
+#endif
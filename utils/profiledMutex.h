@@ -0,0 +1,104 @@
+// profiledMutex.h
+#ifndef PROFILED_MUTEX_H
+#define PROFILED_MUTEX_H
+
+#include <mutex>
+#include <map>
+#include <memory>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "histogram.h"
+
+// lock profiling is compiled in only if LOCK_PROFILING is defined, otherwise ProfiledMutex is a plain std::mutex
+// #define LOCK_PROFILING
+
+// statistics of one named lock, instances with the same name share one entry
+struct LockStats
+{
+    std::string m_name = "";
+    std::atomic<uint64_t> m_acquisitions = 0;
+	std::atomic<uint64_t> m_contendedAcquisitions = 0;  // the lock was held by another thread
+	LatencyHistogram m_waitHistogram;                   // time to acquire (ns), 0 if uncontended
+	LatencyHistogram m_holdHistogram;                   // time from acquire to release (ns), condition variable waits excluded
+};
+
+// registry of the named locks, entries live until the process exits
+class LockProfiler
+{
+public:
+    static LockProfiler& instance();
+
+	// the build records lock statistics
+    static bool isCompiledIn();
+
+	// entry of a lock name, created on first use
+    LockStats* getStats(const std::string& name);
+	// all entries, ordered by name
+    void getAllStats(std::vector<const LockStats*>& refVecStats);
+    void reset();
+
+private:
+    LockProfiler();
+    ~LockProfiler();
+
+    LockProfiler(const LockProfiler&) = delete;
+    LockProfiler& operator=(const LockProfiler&) = delete;
+    LockProfiler(LockProfiler&&) = delete;
+    LockProfiler& operator=(LockProfiler&&) = delete;
+
+    std::map<std::string, std::unique_ptr<LockStats>> m_mapStats{};
+	std::mutex m_mutex;     // lock for m_mapStats
+};
+
+// drop-in replacement of std::mutex (std::lock_guard, std::unique_lock, std::lock) recording acquisitions, contention, wait and hold times
+// a condition variable waits through waitNative(), the lock is handed to the wait as a std::unique_lock<std::mutex>
+class ProfiledMutex
+{
+public:
+#ifdef LOCK_PROFILING
+    explicit ProfiledMutex(const char* name);
+
+    void lock();
+    bool try_lock();
+    void unlock();
+#else
+    explicit ProfiledMutex(const char* /* name */) {}
+
+    void lock() { m_mutex.lock(); }
+    bool try_lock() { return m_mutex.try_lock(); }
+    void unlock() { m_mutex.unlock(); }
+#endif
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+	// call with the lock held, funcWait gets the underlying lock for std::condition_variable (or ClockManager::waitUntil)
+	// the time in the wait is not counted as hold time, the reacquisition after the wait is not counted as an acquisition
+    template <typename Func>
+    void waitNative(Func funcWait)
+    {
+        _endHold();
+        std::unique_lock<std::mutex> nativeLock(m_mutex, std::adopt_lock);
+        funcWait(nativeLock);
+		nativeLock.release();   // still locked, owned by the caller's lock again
+        _beginHold();
+    }
+
+private:
+#ifdef LOCK_PROFILING
+    void _beginHold() { m_holdBeginTime = std::chrono::steady_clock::now(); }
+    void _endHold();
+
+	LockStats* m_pStats = nullptr;
+	std::chrono::steady_clock::time_point m_holdBeginTime{};   // only touched by the holder
+#else
+    void _beginHold() {}
+    void _endHold() {}
+#endif
+    std::mutex m_mutex;
+};
+
+#endif // PROFILED_MUTEX_H
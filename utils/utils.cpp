@@ -4,8 +4,19 @@
 // @date  : 2025-05-15
 #include "utils.h"
 #include <chrono>
-#include <sstream>
-#include <iomanip>
+#include <ctime>
+#include <cstdio>
+#include <random>
+#include <atomic>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <intrin.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace time_utils
 {
@@ -24,25 +35,178 @@ namespace time_utils
     }
     std::string formatTimestampMs(uint64_t timestamp_ms)
     {
+		// "YYYY-MM-DD HH:MM:SS" of the last second formatted by this thread, most calls hit the same second
+        static thread_local std::time_t t_cachedSecond = -1;
+        static thread_local char t_cachedText[32] = { 0 };
+
 		// convert milliseconds to seconds
         std::time_t timeT_in_seconds = static_cast<std::time_t>(timestamp_ms / 1000);
+        if (timeT_in_seconds != t_cachedSecond)
+        {
+            std::tm local_tm_struct;
+
+			// get the local time from the time_t value
+#ifdef _WIN32
+            const bool isConverted = (localtime_s(&local_tm_struct, &timeT_in_seconds) == 0);
+#else
+            const bool isConverted = (localtime_r(&timeT_in_seconds, &local_tm_struct) != nullptr);
+#endif
+            if (!isConverted || std::strftime(t_cachedText, sizeof(t_cachedText), "%Y-%m-%d %H:%M:%S", &local_tm_struct) == 0)
+            {
+                t_cachedSecond = -1;
+                return "Invalid Time (conversion failed)";
+            }
+            t_cachedSecond = timeT_in_seconds;
+        }
+
+		// add milliseconds
+        const uint32_t remaining_ms = static_cast<uint32_t>(timestamp_ms % 1000);
+        char msText[8];
+        std::snprintf(msText, sizeof(msText), ".%03u", remaining_ms);
+
+        std::string result(t_cachedText);
+        result += msText;
+        return result;
+    }
+}
 
-        std::tm local_tm_struct;
+namespace file_utils
+{
+    FILE* openFile(const std::string& path, const char* mode)
+    {
+        FILE* pFile = nullptr;
+#ifdef _WIN32
+        if (fopen_s(&pFile, path.c_str(), mode) != 0)
+        {
+            return nullptr;
+        }
+#else
+        pFile = std::fopen(path.c_str(), mode);
+#endif
+        return pFile;
+    }
 
-		// get the local time from the time_t value
-        if (localtime_s(&local_tm_struct, &timeT_in_seconds) != 0)
+    bool syncFile(FILE* pFile)
+    {
+        if (!pFile)
+        {
+            return false;
+        }
+        if (std::fflush(pFile) != 0)
         {
-            return "Invalid Time (conversion failed)";
+            return false;
         }
+#ifdef _WIN32
+        return (_commit(_fileno(pFile)) == 0);
+#else
+        return (fsync(fileno(pFile)) == 0);
+#endif
+    }
+
+    bool replaceFile(const std::string& srcPath, const std::string& dstPath)
+    {
+#ifdef _WIN32
+        return (MoveFileExA(srcPath.c_str(), dstPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+        return (std::rename(srcPath.c_str(), dstPath.c_str()) == 0);
+#endif
+    }
+}
 
-        std::ostringstream oss;
-		// format the time as "YYYY-MM-DD HH:MM:SS"
-        oss << std::put_time(&local_tm_struct, "%Y-%m-%d %H:%M:%S");
+namespace random_utils
+{
+    static std::atomic<bool> s_hasGlobalSeed = false;
+    static std::atomic<uint64_t> s_globalSeed = 0;
+    static std::atomic<uint64_t> s_threadCounts = 0;   // generators created so far, mixed into the seeds
 
-		// add milliseconds
-        int remaining_ms = timestamp_ms % 1000;
-        oss << "." << std::setw(3) << std::setfill('0') << remaining_ms;
+    static uint64_t splitMix64(uint64_t& refState)
+    {
+        uint64_t z = (refState += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+	// full 128-bit product of two 64-bit numbers, returns the low half
+    static uint64_t multiply128(uint64_t a, uint64_t b, uint64_t& refHigh)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return _umul128(a, b, &refHigh);
+#elif defined(__SIZEOF_INT128__)
+        const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        refHigh = static_cast<uint64_t>(product >> 64);
+        return static_cast<uint64_t>(product);
+#else
+        const uint64_t aLow = a & 0xFFFFFFFFULL, aHigh = a >> 32;
+        const uint64_t bLow = b & 0xFFFFFFFFULL, bHigh = b >> 32;
+        const uint64_t lowLow = aLow * bLow;
+        const uint64_t highLow = aHigh * bLow + (lowLow >> 32);
+        const uint64_t lowHigh = aLow * bHigh + (highLow & 0xFFFFFFFFULL);
+        refHigh = aHigh * bHigh + (highLow >> 32) + (lowHigh >> 32);
+        return (lowHigh << 32) | (lowLow & 0xFFFFFFFFULL);
+#endif
+    }
+
+    static uint64_t newThreadSeed()
+    {
+        const uint64_t threadIndex = s_threadCounts.fetch_add(1);
+        if (s_hasGlobalSeed.load())
+        {
+            uint64_t state = s_globalSeed.load() ^ (threadIndex * 0xD1B54A32D192ED03ULL);
+            return splitMix64(state);
+        }
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd() ^ threadIndex;
+    }
+
+    Xoshiro256::Xoshiro256(uint64_t seed)
+    {
+        for (auto& state : m_arrState)
+        {
+            state = splitMix64(seed);
+        }
+    }
+
+    void setGlobalSeed(uint64_t seed)
+    {
+        s_globalSeed = seed;
+        s_hasGlobalSeed = true;
+    }
 
-        return oss.str();
+    bool hasGlobalSeed()
+    {
+        return s_hasGlobalSeed.load();
+    }
+
+    Xoshiro256& getThreadGenerator()
+    {
+        static thread_local Xoshiro256 t_generator(newThreadSeed());
+        return t_generator;
+    }
+
+    double getRandomUnit()
+    {
+        return static_cast<double>(getThreadGenerator()() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    uint64_t getBounded(uint64_t range)
+    {
+        if (range == 0)
+        {
+            return 0;
+        }
+        Xoshiro256& refGenerator = getThreadGenerator();
+        uint64_t high = 0;
+        uint64_t low = multiply128(refGenerator(), range, high);
+        if (low < range)
+        {
+			// reject the 2^64 % range products that would bias the low results
+            const uint64_t threshold = (0 - range) % range;
+            while (low < threshold)
+            {
+                low = multiply128(refGenerator(), range, high);
+            }
+        }
+        return high;
     }
 }
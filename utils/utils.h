@@ -3,8 +3,11 @@
 #define TIME_UTILS_H
 
 #include <cstdint>
-#include <random>
+#include <cstdio>
 #include <limits>
+#include <type_traits>
+#include <string>
+#include <stdexcept>
 
 namespace time_utils
 {
@@ -12,24 +15,82 @@ namespace time_utils
     uint64_t getTimestamp();
     std::string formatTimestampMs(uint64_t timestamp);
 }
+namespace file_utils
+{
+	// open file with stdio mode (e.g. "rb", "wb", "ab"), return nullptr if failed
+    FILE* openFile(const std::string& path, const char* mode);
+	// flush the stdio buffer and force the file content to the disk
+    bool syncFile(FILE* pFile);
+	// replace the target file with the source file atomically (overwrite if target exists)
+    bool replaceFile(const std::string& srcPath, const std::string& dstPath);
+}
 namespace random_utils
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+	// xoshiro256** generator (256-bit state, period 2^256 - 1), not thread-safe
+	// satisfies UniformRandomBitGenerator, so it also works with the <random> distributions
+    class Xoshiro256
+    {
+    public:
+        using result_type = uint64_t;
+
+		// the state is expanded from the seed with splitmix64 (never all zero)
+        explicit Xoshiro256(uint64_t seed);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        result_type operator()()
+        {
+            const uint64_t result = _rotl(m_arrState[1] * 5, 7) * 9;
+            const uint64_t t = m_arrState[1] << 17;
+            m_arrState[2] ^= m_arrState[0];
+            m_arrState[3] ^= m_arrState[1];
+            m_arrState[1] ^= m_arrState[2];
+            m_arrState[0] ^= m_arrState[3];
+            m_arrState[2] ^= t;
+            m_arrState[3] = _rotl(m_arrState[3], 45);
+            return result;
+        }
+
+    private:
+        static uint64_t _rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        uint64_t m_arrState[4];
+    };
+
+	// make every thread generator deterministic : the n-th thread drawing a number is seeded with (seed, n)
+	// call once at startup, before any number is drawn, threads already seeded keep their sequence
+	// without a global seed every thread is seeded from std::random_device
+    void setGlobalSeed(uint64_t seed);
+    bool hasGlobalSeed();
+
+	// generator of the calling thread, created on first use
+    Xoshiro256& getThreadGenerator();
+
+	// uniform number in [0, range), range 0 gives 0
+	// Lemire's multiply-shift : one multiplication, a division only on the rare rejection path
+    uint64_t getBounded(uint64_t range);
+
+	// uniform number in [0, 1), 53 random bits
+    double getRandomUnit();
 
 	// get random number in range [min, max]
     template <typename T>
     T getRandomRange(T min, T max)
     {
+        static_assert(std::is_integral<T>::value, "random_utils::getRandomRange: integral type required.");
         if (min > max)
         {
             throw std::invalid_argument("random_utils::getRandomRange: min cannot be greater than max.");
         }
 
-		// fixed for the issue of using uint8_t as range
-        std::uniform_int_distribution<int> distrib(static_cast<int>(min), static_cast<int>(max));
-
-        return static_cast<T>(distrib(gen));
+		// work on the two's complement distance, valid for signed and small types (uint8_t)
+        const uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+        if (span == std::numeric_limits<uint64_t>::max())
+        {
+            return static_cast<T>(getThreadGenerator()());
+        }
+        return static_cast<T>(static_cast<uint64_t>(min) + getBounded(span + 1));
     }
 
 	// get random number in range [0, max - 1)